@@ -3,13 +3,10 @@
 #include "../helpers/locale.hpp"
 #include "../helpers/logger.hpp"
 #include "../helpers/process.hpp"
-#include <chrono>
 #include <filesystem>
 #include <iostream>
-#include <mutex>
 #include <poll.h>
 #include <sys/eventfd.h>
-#include <thread>
 #include <unistd.h>
 
 namespace Lawnch::App {
@@ -40,8 +37,7 @@ Application::Application(std::unique_ptr<IPC::Server> server,
     : ipc_server(std::move(server)),
       config_manager(Core::Config::Manager::Instance()),
       icon_manager(Core::Icons::Manager::Instance()),
-      image_cache(ImageCache::ImageCache::Instance()),
-      last_render_time(std::chrono::steady_clock::now()) {
+      image_cache(ImageCache::ImageCache::Instance()) {
 
   std::filesystem::path log_path = Fs::get_log_path("lawnch");
   Logger::init(log_path.string(), verbose, print_logs);
@@ -52,13 +48,15 @@ Application::Application(std::unique_ptr<IPC::Server> server,
                   " print_logs=" + (print_logs ? "true" : "false"));
 
   wakeup_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
-  image_cache.set_render_callback([this]() {
+  auto schedule_render = [this]() {
     uint64_t u = 1;
     if (write(this->wakeup_fd, &u, sizeof(u)) == -1) {
       Logger::log("App", Logger::LogLevel::ERROR,
                   "Failed to write to wakeup_fd to schedule render");
     }
-  });
+  };
+  image_cache.set_render_callback(schedule_render);
+  icon_manager.set_render_callback(schedule_render);
 
   ipc_server->set_on_kill([this]() { this->stop(); });
   try {
@@ -151,12 +149,29 @@ Application::Application(std::unique_ptr<IPC::Server> server,
   layer_surface->on_configure = [this](int w, int h) { this->resize(w, h); };
   layer_surface->on_closed = [this]() { this->stop(); };
 
+  buffer_pool.set_thread_count(config_manager.Get().render_threads);
+  image_cache.set_memory_budget(
+      (size_t)config_manager.Get().preview_image_cache_size * 1024 * 1024);
+  image_cache.set_disk_cache(config_manager.Get().preview_image_cache_disk);
+  image_cache.set_disk_budget(
+      (size_t)config_manager.Get().preview_image_cache_disk_size * 1024 *
+      1024);
+  image_cache.set_shared_thumbnails(
+      config_manager.Get().preview_shared_thumbnails_read,
+      config_manager.Get().preview_shared_thumbnails_write);
+  buffer_pool.on_release = [this]() { waiting_for_buffer = false; };
+
   on_search_results(search_engine->query(""));
 
   Logger::log("App", Logger::LogLevel::INFO, "Initialization Complete");
 }
 
 Application::~Application() {
+  // the singletons outlive us and their workers may still finish a load,
+  // the callbacks are called under the same lock so nothing is in flight
+  // once these return
+  image_cache.set_render_callback(nullptr);
+  icon_manager.set_render_callback(nullptr);
   if (wakeup_fd != -1) {
     close(wakeup_fd);
   }
@@ -164,7 +179,15 @@ Application::~Application() {
 
 void Application::run() {
   running = true;
-  while (running && display->dispatch() != -1) {
+  while (running) {
+    while (display->prepare_read() != 0) {
+      if (display->dispatch_pending() == -1)
+        return;
+    }
+
+    // everything queued so far is handled, paint it in one go
+    paint_if_needed();
+
     struct pollfd fds[4];
     fds[0] = {.fd = display->get_fd(), .events = POLLIN, .revents = 0};
     fds[1] = {
@@ -173,13 +196,19 @@ void Application::run() {
     fds[3] = {.fd = wakeup_fd, .events = POLLIN, .revents = 0};
 
     display->flush();
-    if (poll(fds, 4, -1) < 0)
+    if (poll(fds, 4, -1) < 0) {
+      display->cancel_read();
       break;
+    }
 
     if (fds[0].revents & POLLIN) {
-      if (display->dispatch() == -1)
+      if (display->read_events() == -1)
         break;
+    } else {
+      display->cancel_read();
     }
+    if (display->dispatch_pending() == -1)
+      break;
 
     if (fds[1].revents & POLLIN) {
       seat->handle_repeat();
@@ -194,6 +223,10 @@ void Application::run() {
       if (read(wakeup_fd, &u, sizeof(u)) > 0) {
         Logger::log("App", Logger::LogLevel::DEBUG,
                     "Wakeup received, rendering frame.");
+        // a preview image or an icon finished loading in the background
+        renderer.invalidate_component("preview");
+        if (icon_manager.take_loaded())
+          renderer.invalidate_component("results");
         render_frame();
       }
     }
@@ -206,57 +239,33 @@ void Application::stop() {
 }
 
 void Application::resize(int width, int height) {
-  buffer.create(registry->shm, width, height);
-  if (layer_surface->is_configured() && buffer.is_valid()) {
-    std::lock_guard<std::mutex> lock(render_mutex);
-    render_pending = false;
-    last_render_time = std::chrono::steady_clock::now() - min_frame_time_ms;
-    render_frame_impl();
+  buffer_pool.resize(registry->shm, width, height);
+  renderer.invalidate();
+  render_frame();
+
+  if (!warm_plugins_requested) {
+    warm_plugins_requested = true;
+    plugin_manager->preload_warm_plugins();
   }
 }
 
-void Application::render_frame() {
-  if (!layer_surface->is_configured() || !buffer.is_valid())
-    return;
-
-  auto now = std::chrono::steady_clock::now();
-  auto time_since_last = std::chrono::duration_cast<std::chrono::milliseconds>(
-      now - last_render_time);
+void Application::render_frame() { frame_dirty = true; }
 
-  if (time_since_last >= min_frame_time_ms) {
-    std::lock_guard<std::mutex> lock(render_mutex);
-    render_pending = false;
-    render_frame_impl();
+void Application::paint_if_needed() {
+  if (!frame_dirty || waiting_for_buffer || layer_surface->is_frame_pending())
+    return;
+  if (!layer_surface->is_configured() || !buffer_pool.is_valid())
     return;
-  }
 
-  if (!render_pending) {
-    render_pending = true;
-    auto delay = min_frame_time_ms - time_since_last;
-    std::thread([this, delay]() {
-      std::this_thread::sleep_for(delay);
-      std::lock_guard<std::mutex> lock(render_mutex);
-      if (render_pending) {
-        render_pending = false;
-        if (layer_surface->is_configured() && buffer.is_valid()) {
-          render_frame_impl();
-        }
-      }
-    }).detach();
-  }
+  frame_dirty = false;
+  render_frame_impl();
 }
 
 void Application::render_frame_impl() {
-  if (!layer_surface->is_configured() || !buffer.is_valid()) {
-    return;
-  }
-
-  if (buffer.get_width() <= 0 || buffer.get_height() <= 0) {
+  if (!layer_surface->is_configured() || !buffer_pool.is_valid()) {
     return;
   }
 
-  last_render_time = std::chrono::steady_clock::now();
-
   Core::Window::Render::RenderState state;
   state.search_text = keyboard->get_text();
   state.caret_position = keyboard->get_caret();
@@ -265,12 +274,44 @@ void Application::render_frame_impl() {
   state.selected_index = keyboard->get_selected_index();
   state.scroll_offset = scroll_offset;
 
-  renderer.render(buffer.get_context(), buffer.get_width(), buffer.get_height(),
-                  config_manager.Get(), state);
+  int width = buffer_pool.get_width();
+  int height = buffer_pool.get_height();
+  const auto &cfg = config_manager.Get();
+  auto damage = renderer.compute_damage(width, height, cfg, state);
+  if (damage.empty())
+    return;
+
+  // the compositor still holds every buffer, retry once one is released
+  Core::Window::Render::Buffer *buffer = buffer_pool.acquire();
+  if (!buffer) {
+    waiting_for_buffer = true;
+    frame_dirty = true;
+    return;
+  }
+
+  // the buffer may be a few frames old, so repaint what changed since then
+  buffer_pool.add_damage(damage);
+  auto repaint = buffer->take_damage();
+
+  // plain scrolling moves pixels instead of redrawing every row
+  Core::Window::Render::Buffer *previous = buffer_pool.get_previous();
+  if (auto blit = renderer.scroll_blit(
+          buffer->get_image(), previous ? &previous->get_image() : nullptr,
+          repaint, cfg, state)) {
+    repaint = std::move(*blit);
+  }
+
+  renderer.render(buffer->get_context(), width, height, cfg, state, repaint);
+  // with render.threads the workers may still be writing, wait for them
+  // before the compositor gets the buffer
+  buffer->get_context().flush(BL_CONTEXT_FLUSH_SYNC);
 
-  if (buffer.is_valid() && layer_surface->is_configured()) {
-    layer_surface->commit(buffer.get_wl_buffer());
+  std::vector<Core::Window::Wayland::LayerSurface::DamageRect> surface_damage;
+  for (const auto &rect : damage) {
+    surface_damage.push_back({rect.x, rect.y, rect.w, rect.h});
   }
+  layer_surface->commit(buffer->get_wl_buffer(), surface_damage);
+  buffer_pool.set_presented(buffer);
 }
 
 void Application::on_keyboard_update() {
@@ -423,7 +464,8 @@ void Application::on_pointer_scroll(double delta) {
       renderer.get_visible_count(layer_surface->get_height(), cfg);
   int total = (int)current_results.size();
 
-  if (cfg.results_scroll == "fixed") {
+  if (config_manager.GetStyle().results_scroll ==
+      Core::Config::ScrollMode::Fixed) {
     int sel = keyboard->get_selected_index();
 
     if (delta > 0) { // scroll down
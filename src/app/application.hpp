@@ -1,11 +1,9 @@
 #pragma once
 
 #include "../ipc/server.hpp"
-#include <chrono>
 #include <memory>
 #include <optional>
 #include <stack>
-#include <thread>
 #include <vector>
 
 #include "../core/config/manager.hpp"
@@ -15,7 +13,7 @@
 #include "../core/window/input/history.hpp"
 #include "../core/window/input/keyboard.hpp"
 #include "../core/window/input/pointer.hpp"
-#include "../core/window/render/buffer.hpp"
+#include "../core/window/render/buffer_pool.hpp"
 #include "../core/window/render/renderer.hpp"
 #include "../core/window/wayland/display.hpp"
 #include "../core/window/wayland/layer_surface.hpp"
@@ -40,9 +38,11 @@ private:
   bool running = false;
   int wakeup_fd = -1;
 
-  std::chrono::steady_clock::time_point last_render_time;
-  static constexpr std::chrono::milliseconds min_frame_time_ms{16};
-  bool render_pending = false;
+  // state changed since the last paint; painted once the compositor asks
+  // for the next frame
+  bool frame_dirty = false;
+  bool waiting_for_buffer = false;
+  bool warm_plugins_requested = false;
 
   std::unique_ptr<IPC::Server> ipc_server;
 
@@ -62,7 +62,7 @@ private:
   std::unique_ptr<Core::Window::Input::Keyboard> keyboard;
   std::unique_ptr<Core::Window::Input::Pointer> pointer;
 
-  Core::Window::Render::Buffer buffer;
+  Core::Window::Render::BufferPool buffer_pool;
   Core::Window::Render::Renderer renderer;
 
   std::vector<Core::Search::SearchResult> current_results;
@@ -83,10 +83,9 @@ private:
 
   void resize(int width, int height);
   void render_frame();
+  void paint_if_needed();
   void render_frame_impl();
 
-  std::mutex render_mutex;
-
   // Sub-menu navigation stack (infinite depth)
   struct NavStackEntry {
     std::vector<Core::Search::SearchResult> results;
@@ -1,10 +1,13 @@
 #include "pm.hpp"
 #include "../helpers/fs.hpp"
+#include "../core/search/plugins/stats.hpp"
 #include "../helpers/string.hpp"
+#include <algorithm>
 #include <cstdio>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
+#include <iomanip>
 #include <iostream>
 #include <set>
 #include <sstream>
@@ -23,6 +26,7 @@ void PluginManager::print_help() {
             << "  enable <name>               Enable a plugin\n"
             << "  disable <name>              Disable a plugin\n"
             << "  info <name>                 Show plugin info\n"
+            << "  stats [name|--reset]        Show plugin load/query timings\n"
             << "  help                        Show this help\n\n"
             << "URL Install:\n"
             << "  lawnch pm install https://github.com/user/plugin-repo\n"
@@ -75,6 +79,12 @@ int PluginManager::handle_command(const std::vector<std::string> &args) {
       if (args.size() < 2)
         throw std::runtime_error("Missing plugin name");
       info(args[1]);
+    } else if (command == "stats") {
+      if (args.size() > 1 && args[1] == "--reset") {
+        reset_stats();
+      } else {
+        stats(args.size() > 1 ? args[1] : "");
+      }
     } else {
       std::cerr << "Unknown command: " << command << std::endl;
       print_help();
@@ -503,4 +513,57 @@ void PluginManager::info(const std::string &plugin_name) {
             << "URL: " << info.url << "\n";
 }
 
+void PluginManager::stats(const std::string &filter) {
+  using Lawnch::Core::Search::Plugins::PluginStats;
+
+  auto all = PluginStats::load_file();
+  std::vector<std::pair<std::string, PluginStats>> rows;
+  for (const auto &[name, s] : all) {
+    if (filter.empty() || name.find(filter) != std::string::npos)
+      rows.emplace_back(name, s);
+  }
+
+  if (rows.empty()) {
+    std::cout << "No plugin stats recorded"
+              << (filter.empty() ? "." : " matching filter: " + filter) << "\n";
+    return;
+  }
+
+  // slowest first, that is what this is for
+  std::sort(rows.begin(), rows.end(), [](const auto &a, const auto &b) {
+    return a.second.latency_percentile_ms(95) >
+           b.second.latency_percentile_ms(95);
+  });
+
+  auto avg = [](double total, uint64_t n) { return n ? total / n : 0.0; };
+
+  std::cout << std::left << std::setw(16) << "PLUGIN" << std::right
+            << std::setw(7) << "LOADS" << std::setw(10) << "DLOPEN"
+            << std::setw(10) << "INIT" << std::setw(9) << "QUERIES"
+            << std::setw(9) << "P50" << std::setw(9) << "P95" << std::setw(9)
+            << "P99" << std::setw(9) << "RESULTS" << "\n";
+
+  std::cout << std::fixed << std::setprecision(2);
+  for (const auto &[name, s] : rows) {
+    std::cout << std::left << std::setw(16) << name << std::right
+              << std::setw(7) << s.loads << std::setw(8)
+              << avg(s.dlopen_ms, s.loads) << "ms" << std::setw(8)
+              << avg(s.init_ms, s.loads) << "ms" << std::setw(9)
+              << s.queries << std::setw(7) << s.latency_percentile_ms(50)
+              << "ms" << std::setw(7) << s.latency_percentile_ms(95) << "ms"
+              << std::setw(7) << s.latency_percentile_ms(99) << "ms"
+              << std::setw(9) << avg(s.results, s.queries) << "\n";
+  }
+  std::cout << "\nTimes are averages per load or query. Percentiles are "
+               "bucket upper\nbounds.\n";
+}
+
+void PluginManager::reset_stats() {
+  using Lawnch::Core::Search::Plugins::PluginStats;
+
+  std::error_code ec;
+  std::filesystem::remove(PluginStats::file_path(), ec);
+  std::cout << "Plugin stats cleared.\n";
+}
+
 } // namespace Lawnch::CLI
@@ -32,6 +32,8 @@ private:
   static void enable(const std::string &plugin_name);
   static void disable(const std::string &plugin_name);
   static void info(const std::string &plugin_name);
+  static void stats(const std::string &filter);
+  static void reset_stats();
 };
 
 } // namespace Lawnch::CLI
@@ -19,6 +19,7 @@ void Manager::Impl::ApplyToml(const toml::table &root) {
   ApplyLaunch(root);
   ApplyKeybindings(root);
   ApplyWindow(root);
+  ApplyRender(root);
   ApplyInput(root);
   ApplyInputPrompt(root);
   ApplyResults(root);
@@ -127,6 +128,15 @@ void Manager::Impl::ApplyWindow(const toml::table &root) {
   config.window_keyboard = getStr(*t, "keyboard", config.window_keyboard);
 }
 
+void Manager::Impl::ApplyRender(const toml::table &root) {
+  auto *t = getTable(root, "render");
+  if (!t)
+    return;
+
+  config.render_threads =
+      std::max(0, getInt(*t, "threads", config.render_threads));
+}
+
 void Manager::Impl::ApplyInput(const toml::table &root) {
   auto *t = getTable(root, "widget.input");
   if (!t)
@@ -426,6 +436,29 @@ void Manager::Impl::ApplyPreview(const toml::table &root) {
       }
     }
 
+    if (auto cnode = (*t)["image-cache"]; cnode) {
+      if (auto ct = cnode.as_table()) {
+        // below a few previews the selection and the rows prefetched
+        // around it keep pushing each other out
+        config.preview_image_cache_size = std::max(
+            8, getInt(*ct, "size", config.preview_image_cache_size));
+        config.preview_image_cache_disk =
+            getBool(*ct, "disk", config.preview_image_cache_disk);
+        config.preview_image_cache_disk_size =
+            std::max(0, getInt(*ct, "disk-size",
+                               config.preview_image_cache_disk_size));
+      }
+    }
+
+    if (auto snode = (*t)["shared-thumbnails"]; snode) {
+      if (auto st = snode.as_table()) {
+        config.preview_shared_thumbnails_read =
+            getBool(*st, "read", config.preview_shared_thumbnails_read);
+        config.preview_shared_thumbnails_write =
+            getBool(*st, "write", config.preview_shared_thumbnails_write);
+      }
+    }
+
     if (auto gnode = (*t)["gap"]; gnode) {
       if (auto gt = gnode.as_table()) {
         config.preview_gap_v = getInt(*gt, "v", config.preview_gap_v);
@@ -537,9 +570,16 @@ void Manager::Impl::ApplyPlugins(const toml::table &root) {
         config.enabled_plugins.push_back(plugin_name);
     }
 
+    if (getBool(*pt, "preload", false)) {
+      if (std::find(config.preload_plugins.begin(),
+                    config.preload_plugins.end(),
+                    plugin_name) == config.preload_plugins.end())
+        config.preload_plugins.push_back(plugin_name);
+    }
+
     for (auto &[pk, pv] : *pt) {
       std::string pk_str(pk.str());
-      if (pk_str == "enable")
+      if (pk_str == "enable" || pk_str == "preload")
         continue;
 
       std::string cfg_key = plugin_name + "." + pk_str;
@@ -48,6 +48,9 @@ struct Config {
   bool window_ignore_exclusive;
   std::string window_keyboard;
 
+  // render
+  int render_threads;
+
   // input
   bool input_visible;
   std::string input_font_family;
@@ -136,6 +139,11 @@ struct Config {
   bool preview_enable;
   int preview_icon_size;
   int preview_image_size;
+  int preview_image_cache_size; // MiB of decoded previews kept in memory
+  bool preview_image_cache_disk;
+  int preview_image_cache_disk_size; // MiB of scaled copies kept on disk
+  bool preview_shared_thumbnails_read; // ~/.cache/thumbnails
+  bool preview_shared_thumbnails_write;
   bool preview_icon_hide_on_fallback;
   bool preview_icon_fallback;
   Padding preview_padding;
@@ -188,6 +196,7 @@ struct Config {
 
   // plugins
   std::vector<std::string> enabled_plugins;
+  std::vector<std::string> preload_plugins;
   std::map<std::string, std::string> plugin_configs;
 
   // keybindings
@@ -42,6 +42,9 @@ void Manager::Impl::SetDefaults() {
   config.window_ignore_exclusive = false;
   config.window_keyboard = "exclusive";
 
+  // render
+  config.render_threads = 0;
+
   // input
   config.input_visible = true;
   config.input_font_family = "sans-serif";
@@ -130,6 +133,11 @@ void Manager::Impl::SetDefaults() {
   config.preview_enable = false;
   config.preview_icon_size = 64;
   config.preview_image_size = 64;
+  config.preview_image_cache_size = 64;
+  config.preview_image_cache_disk = true;
+  config.preview_image_cache_disk_size = 256;
+  config.preview_shared_thumbnails_read = true;
+  config.preview_shared_thumbnails_write = false;
   config.preview_icon_hide_on_fallback = false;
   config.preview_icon_fallback = false;
   config.preview_padding = Padding(10);
@@ -182,6 +190,7 @@ void Manager::Impl::SetDefaults() {
   config.keybindings_inherit = "default";
 
   config.enabled_plugins.clear();
+  config.preload_plugins.clear();
   config.plugin_configs.clear();
   config.keybindings.clear();
   config.theme_colors.clear();
@@ -55,6 +55,7 @@ void Manager::Impl::LoadPresetFile(const std::string &name,
 void Manager::Load(const std::string &path) {
   std::unique_lock lock(m_impl->config_mutex);
   m_impl->SetDefaults();
+  ++m_impl->generation;
 
   toml::table user_config;
   try {
@@ -63,6 +64,7 @@ void Manager::Load(const std::string &path) {
     Logger::log("Config", Logger::LogLevel::WARNING,
                 "Unable to parse '" + path + "': " + std::string(e.what()) +
                     ". Using defaults.");
+    m_impl->style = compileStyle(m_impl->config);
     return;
   }
 
@@ -84,6 +86,7 @@ void Manager::Load(const std::string &path) {
   }
 
   m_impl->ApplyToml(user_config);
+  m_impl->style = compileStyle(m_impl->config);
 
   Logger::log("Config", Logger::LogLevel::INFO,
               "Configuration loaded from '" + path + "'");
@@ -94,6 +97,8 @@ void Manager::Merge(const std::string &path) {
   try {
     auto tbl = toml::parse_file(path);
     m_impl->ApplyToml(tbl);
+    m_impl->style = compileStyle(m_impl->config);
+    ++m_impl->generation;
     Logger::log("Config", Logger::LogLevel::INFO,
                 "Merged configuration from '" + path + "'");
   } catch (const toml::parse_error &e) {
@@ -108,4 +113,14 @@ const Config &Manager::Get() const {
   return m_impl->config;
 }
 
+const Style &Manager::GetStyle() const {
+  std::shared_lock lock(m_impl->config_mutex);
+  return m_impl->style;
+}
+
+uint64_t Manager::Generation() const {
+  std::shared_lock lock(m_impl->config_mutex);
+  return m_impl->generation;
+}
+
 } // namespace Lawnch::Core::Config
@@ -1,11 +1,14 @@
 #pragma once
 
 #include "config.hpp"
+#include <cstdint>
 #include <memory>
 #include <string>
 
 namespace Lawnch::Core::Config {
 
+struct Style;
+
 class Manager {
 public:
   static Manager &Instance();
@@ -19,6 +22,10 @@ public:
   void Merge(const std::string &path);
 
   [[nodiscard]] const Config &Get() const;
+  // Get() compiled for rendering, see style.hpp
+  [[nodiscard]] const Style &GetStyle() const;
+  // bumped on every Load/Merge so derived state can tell it is stale
+  [[nodiscard]] uint64_t Generation() const;
 
 private:
   Manager();
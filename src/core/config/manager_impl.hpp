@@ -2,6 +2,7 @@
 
 #include "config.hpp"
 #include "manager.hpp"
+#include "style.hpp"
 
 #include "../../helpers/config_parse.hpp"
 #include "../../helpers/fs.hpp"
@@ -162,6 +163,8 @@ inline std::filesystem::path findDataFile(const std::string &subdir,
 struct Manager::Impl {
   Config config;
   mutable std::shared_mutex config_mutex;
+  Style style;
+  uint64_t generation = 0;
 
   void SetDefaults();
   void LoadThemeColors(const toml::table &theme_tbl);
@@ -175,6 +178,7 @@ struct Manager::Impl {
   void ApplyLaunch(const toml::table &root);
   void ApplyKeybindings(const toml::table &root);
   void ApplyWindow(const toml::table &root);
+  void ApplyRender(const toml::table &root);
   void ApplyInput(const toml::table &root);
   void ApplyInputPrompt(const toml::table &root);
   void ApplyResults(const toml::table &root);
@@ -0,0 +1,120 @@
+#include "style.hpp"
+#include "../../helpers/gfx.hpp"
+
+namespace Lawnch::Core::Config {
+
+static Align parseAlign(const std::string &value) {
+  if (value == "center")
+    return Align::Center;
+  if (value == "right")
+    return Align::Right;
+  return Align::Left;
+}
+
+static StyleFont resolveFont(const std::string &family, int size,
+                             const std::string &weight) {
+  StyleFont f;
+  f.font = Lawnch::Gfx::get_font(family, size, weight);
+  f.metrics = f.font.metrics();
+  f.height = f.metrics.ascent + f.metrics.descent;
+  return f;
+}
+
+Style compileStyle(const Config &c) {
+  using Lawnch::Gfx::toBLColor;
+  Style s;
+
+  s.input_align = parseAlign(c.input_align);
+  s.result_item_align = parseAlign(c.result_item_align);
+  s.results_count_align = parseAlign(c.results_count_align);
+  s.clock_align = parseAlign(c.clock_align);
+  if (c.layout_preview_side == "left")
+    s.layout_preview_side = PreviewSide::Left;
+  else if (c.layout_preview_side == "right")
+    s.layout_preview_side = PreviewSide::Right;
+  else
+    s.layout_preview_side = PreviewSide::Bottom;
+  s.input_prompt_side =
+      c.input_prompt_side == "right" ? PromptSide::Right : PromptSide::Left;
+  s.results_scroll =
+      c.results_scroll == "fixed" ? ScrollMode::Fixed : ScrollMode::Follow;
+
+  // window
+  s.window_background = toBLColor(c.window_background);
+  s.window_border_color = toBLColor(c.window_border_color);
+
+  // input
+  s.input_font = resolveFont(c.input_font_family, c.input_font_size,
+                             c.input_font_weight);
+  s.input_text = toBLColor(c.input_text);
+  s.input_placeholder_color = toBLColor(c.input_placeholder_color);
+  s.input_background = toBLColor(c.input_background);
+  s.input_caret_color = toBLColor(c.input_caret_color);
+  s.input_selection_color = toBLColor(c.input_selection_color);
+  s.input_selection_text = toBLColor(c.input_selection_text);
+  s.input_border_color = toBLColor(c.input_border_color);
+
+  // input prompt
+  s.input_prompt_font =
+      resolveFont(c.input_prompt_font_family, c.input_prompt_font_size,
+                  c.input_prompt_font_weight);
+  s.input_prompt_color = toBLColor(c.input_prompt_color);
+  s.input_prompt_background = toBLColor(c.input_prompt_background);
+  s.input_prompt_border_color = toBLColor(c.input_prompt_border_color);
+
+  // results
+  s.results_background = toBLColor(c.results_background);
+  s.results_border_color = toBLColor(c.results_border_color);
+  s.results_scrollbar_thumb = toBLColor(c.results_scrollbar_thumb);
+  s.results_scrollbar_track = toBLColor(c.results_scrollbar_track);
+
+  // result item
+  s.result_item_font =
+      resolveFont(c.result_item_font_family, c.result_item_font_size,
+                  c.result_item_font_weight);
+  s.result_item_comment_font =
+      resolveFont(c.result_item_font_family, c.result_item_comment_font_size,
+                  c.result_item_comment_font_weight);
+  s.result_item_highlight_font =
+      resolveFont(c.result_item_font_family, c.result_item_font_size,
+                  c.result_item_highlight_font_weight);
+  s.result_item_comment_color = toBLColor(c.result_item_comment_color);
+  s.result_item_selected_comment = toBLColor(c.result_item_selected_comment);
+  s.result_item_border_color = toBLColor(c.result_item_border_color);
+  s.result_item_background = toBLColor(c.result_item_background);
+  s.result_item_text = toBLColor(c.result_item_text);
+  s.result_item_selected_border_color =
+      toBLColor(c.result_item_selected_border_color);
+  s.result_item_selected_background =
+      toBLColor(c.result_item_selected_background);
+  s.result_item_selected_text = toBLColor(c.result_item_selected_text);
+  s.result_item_highlight_color = toBLColor(c.result_item_highlight_color);
+  s.result_item_selected_highlight =
+      toBLColor(c.result_item_selected_highlight);
+
+  // preview
+  s.preview_title_font =
+      resolveFont(c.preview_title_font_family, c.preview_title_font_size,
+                  c.preview_title_font_weight);
+  s.preview_description_font = resolveFont(c.preview_title_font_family,
+                                           c.preview_description_font_size,
+                                           c.preview_description_font_weight);
+  s.preview_background = toBLColor(c.preview_background);
+  s.preview_title_color = toBLColor(c.preview_title_color);
+  s.preview_description_color = toBLColor(c.preview_description_color);
+
+  // results count
+  s.results_count_font =
+      resolveFont(c.results_count_font_family, c.results_count_font_size,
+                  c.results_count_font_weight);
+  s.results_count_text = toBLColor(c.results_count_text);
+
+  // clock
+  s.clock_font = resolveFont(c.clock_font_family, c.clock_font_size,
+                             c.clock_font_weight);
+  s.clock_text = toBLColor(c.clock_text);
+
+  return s;
+}
+
+} // namespace Lawnch::Core::Config
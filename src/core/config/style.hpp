@@ -0,0 +1,92 @@
+#pragma once
+
+#include "config.hpp"
+#include <blend2d.h>
+
+namespace Lawnch::Core::Config {
+
+enum class Align { Left, Center, Right };
+enum class PreviewSide { Bottom, Left, Right };
+enum class PromptSide { Left, Right };
+enum class ScrollMode { Follow, Fixed };
+
+// A font resolved through fontconfig along with the metrics components keep
+// asking for.
+struct StyleFont {
+  BLFont font;
+  BLFontMetrics metrics{};
+  double height = 0; // ascent + descent
+};
+
+// The parts of Config the renderer reads on every frame, compiled once per
+// Load/Merge: option strings become enums, colors are converted for blend2d
+// and fonts are looked up ahead of time.
+struct Style {
+  Align input_align = Align::Left;
+  Align result_item_align = Align::Left;
+  Align results_count_align = Align::Right;
+  Align clock_align = Align::Center;
+  PreviewSide layout_preview_side = PreviewSide::Bottom;
+  PromptSide input_prompt_side = PromptSide::Left;
+  ScrollMode results_scroll = ScrollMode::Follow;
+
+  // window
+  BLRgba32 window_background;
+  BLRgba32 window_border_color;
+
+  // input
+  StyleFont input_font;
+  BLRgba32 input_text;
+  BLRgba32 input_placeholder_color;
+  BLRgba32 input_background;
+  BLRgba32 input_caret_color;
+  BLRgba32 input_selection_color;
+  BLRgba32 input_selection_text;
+  BLRgba32 input_border_color;
+
+  // input prompt
+  StyleFont input_prompt_font;
+  BLRgba32 input_prompt_color;
+  BLRgba32 input_prompt_background;
+  BLRgba32 input_prompt_border_color;
+
+  // results
+  BLRgba32 results_background;
+  BLRgba32 results_border_color;
+  BLRgba32 results_scrollbar_thumb;
+  BLRgba32 results_scrollbar_track;
+
+  // result item
+  StyleFont result_item_font;
+  StyleFont result_item_comment_font;
+  StyleFont result_item_highlight_font;
+  BLRgba32 result_item_comment_color;
+  BLRgba32 result_item_selected_comment;
+  BLRgba32 result_item_border_color;
+  BLRgba32 result_item_background;
+  BLRgba32 result_item_text;
+  BLRgba32 result_item_selected_border_color;
+  BLRgba32 result_item_selected_background;
+  BLRgba32 result_item_selected_text;
+  BLRgba32 result_item_highlight_color;
+  BLRgba32 result_item_selected_highlight;
+
+  // preview
+  StyleFont preview_title_font;
+  StyleFont preview_description_font;
+  BLRgba32 preview_background;
+  BLRgba32 preview_title_color;
+  BLRgba32 preview_description_color;
+
+  // results count
+  StyleFont results_count_font;
+  BLRgba32 results_count_text;
+
+  // clock
+  StyleFont clock_font;
+  BLRgba32 clock_text;
+};
+
+Style compileStyle(const Config &config);
+
+} // namespace Lawnch::Core::Config
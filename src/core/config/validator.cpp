@@ -45,6 +45,8 @@ static const std::set<std::string> VALID_CONFIG_KEYS = {
     "window.ignore-exclusive",
     "window.keyboard",
 
+    "render.threads",
+
     "widget.input.font",
     "widget.input.text",
     "widget.input.placeholder",
@@ -113,6 +115,8 @@ static const std::set<std::string> VALID_CONFIG_KEYS = {
     "widget.preview.enable",
     "widget.preview.composition",
     "widget.preview.image-size",
+    "widget.preview.image-cache",
+    "widget.preview.shared-thumbnails",
     "widget.preview.icon",
     "widget.preview.padding",
     "widget.preview.background",
@@ -0,0 +1,145 @@
+#include "atlas.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace Lawnch::Core::Icons {
+
+namespace {
+
+// pixels all pages may take together
+constexpr size_t ATLAS_BUDGET = 32 * 1024 * 1024;
+constexpr int MIN_PAGE_SIDE = 256;
+constexpr int MAX_PAGE_SIDE = 1024;
+
+// room for a few dozen icons, but never smaller than one
+int page_side(int icon_size) {
+  int side = (int)std::bit_ceil((unsigned)icon_size * 8);
+  side = std::clamp(side, MIN_PAGE_SIDE, MAX_PAGE_SIDE);
+  return std::max(side, (int)std::bit_ceil((unsigned)icon_size));
+}
+
+size_t page_bytes(const BLImage &image) {
+  return (size_t)image.width() * image.height() * 4;
+}
+
+} // namespace
+
+bool Atlas::Page::allocate(int w, int h, BLPointI &at) {
+  if (shelf_x + w > image.width()) {
+    shelf_y += shelf_h;
+    shelf_x = shelf_h = 0;
+  }
+  if (w > image.width() || shelf_y + h > image.height())
+    return false;
+
+  at = BLPointI(shelf_x, shelf_y);
+  shelf_x += w;
+  shelf_h = std::max(shelf_h, h);
+  return true;
+}
+
+BLImage Atlas::fit(const BLImage &image, int size) {
+  if (size <= 0 || image.empty())
+    return image;
+
+  double scale = std::min((double)size / image.width(),
+                          (double)size / image.height());
+  int w = std::max(1, (int)std::lround(image.width() * scale));
+  int h = std::max(1, (int)std::lround(image.height() * scale));
+  if (w == image.width() && h == image.height())
+    return image;
+
+  BLImage scaled;
+  if (scaled.create(w, h, BL_FORMAT_PRGB32) != BL_SUCCESS)
+    return image;
+  BLContext ctx(scaled);
+  ctx.set_comp_op(BL_COMP_OP_SRC_COPY);
+  ctx.blit_image(BLRect(0, 0, w, h), image);
+  ctx.end();
+  return scaled;
+}
+
+bool Atlas::find(const std::string &key, Slot &out) {
+  auto it = entries.find(key);
+  if (it == entries.end())
+    return false;
+
+  pages.splice(pages.begin(), pages, it->second.page);
+  out.page = &it->second.page->image;
+  out.area = it->second.area;
+  return true;
+}
+
+bool Atlas::insert(const std::string &key, int size, const BLImage &image,
+                   Slot &out) {
+  if (size <= 0 || image.empty())
+    return false;
+  if (find(key, out))
+    return true;
+
+  BLImage fitted = fit(image, size);
+  int w = fitted.width();
+  int h = fitted.height();
+
+  auto page = pages.end();
+  BLPointI at;
+  for (auto it = pages.begin(); it != pages.end(); ++it) {
+    if (it->icon_size == size && it->allocate(w, h, at)) {
+      page = it;
+      break;
+    }
+  }
+
+  if (page == pages.end()) {
+    Page fresh;
+    fresh.icon_size = size;
+    int side = page_side(size);
+    if (fresh.image.create(side, side, BL_FORMAT_PRGB32) != BL_SUCCESS)
+      return false;
+    BLContext ctx(fresh.image);
+    ctx.clear_all();
+    ctx.end();
+    fresh.allocate(w, h, at);
+    pages.push_front(std::move(fresh));
+    page = pages.begin();
+    used_bytes += page_bytes(page->image);
+    evict(page);
+  } else {
+    pages.splice(pages.begin(), pages, page);
+  }
+
+  BLContext ctx(page->image);
+  ctx.set_comp_op(BL_COMP_OP_SRC_COPY);
+  ctx.blit_image(at, fitted);
+  ctx.end();
+
+  page->keys.push_back(key);
+  BLRectI area(at.x, at.y, w, h);
+  entries[key] = {page, area};
+
+  out.page = &page->image;
+  out.area = area;
+  return true;
+}
+
+void Atlas::evict(const std::list<Page>::iterator &keep) {
+  while (used_bytes > ATLAS_BUDGET && pages.size() > 1) {
+    auto victim = std::prev(pages.end());
+    if (victim == keep)
+      break;
+    for (const auto &key : victim->keys) {
+      entries.erase(key);
+    }
+    used_bytes -= page_bytes(victim->image);
+    pages.erase(victim);
+  }
+}
+
+void Atlas::clear() {
+  pages.clear();
+  entries.clear();
+  used_bytes = 0;
+}
+
+} // namespace Lawnch::Core::Icons
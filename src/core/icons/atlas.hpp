@@ -0,0 +1,56 @@
+#pragma once
+
+#include <blend2d.h>
+#include <cstddef>
+#include <list>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Lawnch::Core::Icons {
+
+// Loaded icons packed into a few shelf-packed pages per icon size. Pages are
+// evicted whole, least recently drawn first, once they add up to more than
+// the memory budget.
+class Atlas {
+public:
+  struct Slot {
+    const BLImage *page = nullptr;
+    BLRectI area{}; // within the page
+  };
+
+  // `image` scaled to fit a size x size box, as it is packed
+  static BLImage fit(const BLImage &image, int size);
+
+  // Touches the page the icon lives on.
+  bool find(const std::string &key, Slot &out);
+  // Packs `image` scaled with fit(), evicting pages as needed.
+  bool insert(const std::string &key, int size, const BLImage &image,
+              Slot &out);
+  void clear();
+
+private:
+  struct Page {
+    int icon_size = 0;
+    BLImage image;
+    int shelf_x = 0;
+    int shelf_y = 0;
+    int shelf_h = 0;
+    std::vector<std::string> keys;
+
+    bool allocate(int w, int h, BLPointI &at);
+  };
+
+  struct Entry {
+    std::list<Page>::iterator page;
+    BLRectI area;
+  };
+
+  std::list<Page> pages; // most recently used first
+  std::unordered_map<std::string, Entry> entries;
+  size_t used_bytes = 0;
+
+  void evict(const std::list<Page>::iterator &keep);
+};
+
+} // namespace Lawnch::Core::Icons
@@ -0,0 +1,264 @@
+#include "disk_cache.hpp"
+#include "../../helpers/fs.hpp"
+#include "../../helpers/logger.hpp"
+#include <cstring>
+#include <fcntl.h>
+#include <filesystem>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace Lawnch::Core::Icons {
+
+namespace {
+
+// bumped whenever the file layout changes
+constexpr uint32_t CACHE_VERSION = 1;
+constexpr char CACHE_MAGIC[4] = {'L', 'W', 'I', 'C'};
+// keeps every tile's first row aligned for SIMD blits
+constexpr uint64_t PIXEL_ALIGNMENT = 16;
+// uninstalled apps and sizes no longer in use drop out after this many
+// saves without being asked for
+constexpr uint32_t MAX_UNUSED_RUNS = 8;
+
+// Layout: FileHeader, theme chain, then one EntryHeader followed by its key
+// and source path per entry. Pixels come after all entries, each tile at
+// its own aligned pixel_offset.
+struct FileHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t entry_count;
+  uint32_t chain_length;
+};
+
+struct EntryHeader {
+  uint32_t key_length;
+  uint32_t source_length;
+  int64_t mtime;
+  int32_t width;
+  int32_t height;
+  uint32_t stride;
+  uint32_t unused_runs;
+  uint64_t pixel_offset;
+};
+
+fs::path get_cache_path() {
+  return ::Lawnch::Fs::get_cache_home() / "lawnch" / "icons.cache";
+}
+
+std::optional<int64_t> get_mtime(const std::string &path) {
+  std::error_code ec;
+  auto mtime = fs::last_write_time(path, ec);
+  if (ec)
+    return std::nullopt;
+  return (int64_t)mtime.time_since_epoch().count();
+}
+
+uint64_t align_up(uint64_t value) {
+  return (value + PIXEL_ALIGNMENT - 1) & ~(PIXEL_ALIGNMENT - 1);
+}
+
+} // namespace
+
+DiskCache::~DiskCache() { close(); }
+
+void DiskCache::close() {
+  entries.clear();
+  if (mapping)
+    munmap(mapping, mapping_size);
+  mapping = nullptr;
+  mapping_size = 0;
+}
+
+void DiskCache::open(const std::string &chain) {
+  std::lock_guard<std::mutex> lock(mutex);
+  close();
+  theme_chain = chain;
+  dirty = false;
+
+  int fd = ::open(get_cache_path().c_str(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0)
+    return;
+
+  struct stat st;
+  if (fstat(fd, &st) < 0 || (size_t)st.st_size < sizeof(FileHeader)) {
+    ::close(fd);
+    return;
+  }
+
+  void *mapped = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+  ::close(fd);
+  if (mapped == MAP_FAILED)
+    return;
+  mapping = mapped;
+  mapping_size = st.st_size;
+
+  const auto *data = static_cast<const uint8_t *>(mapping);
+  FileHeader header;
+  std::memcpy(&header, data, sizeof(header));
+  size_t pos = sizeof(header);
+  if (std::memcmp(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC)) != 0 ||
+      header.version != CACHE_VERSION ||
+      header.chain_length > mapping_size - pos ||
+      std::string((const char *)data + pos, header.chain_length) != chain) {
+    close();
+    return;
+  }
+  pos += header.chain_length;
+
+  for (uint32_t i = 0; i < header.entry_count; ++i) {
+    EntryHeader entry;
+    if (sizeof(entry) > mapping_size - pos)
+      break;
+    std::memcpy(&entry, data + pos, sizeof(entry));
+    pos += sizeof(entry);
+
+    if ((uint64_t)entry.key_length + entry.source_length > mapping_size - pos)
+      break;
+    std::string key((const char *)data + pos, entry.key_length);
+    pos += entry.key_length;
+    std::string source((const char *)data + pos, entry.source_length);
+    pos += entry.source_length;
+
+    uint64_t pixels_size = (uint64_t)entry.stride * entry.height;
+    if (entry.width <= 0 || entry.height <= 0 ||
+        entry.stride < (uint64_t)entry.width * 4 ||
+        entry.pixel_offset > mapping_size ||
+        pixels_size > mapping_size - entry.pixel_offset)
+      break;
+
+    // read only, blend2d copies the pixels if anyone tries to write to them
+    Entry cached;
+    cached.source = std::move(source);
+    cached.mtime = entry.mtime;
+    cached.unused_runs = entry.unused_runs;
+    if (cached.image.create_from_data(
+            entry.width, entry.height, BL_FORMAT_PRGB32,
+            (void *)(data + entry.pixel_offset), entry.stride,
+            BL_DATA_ACCESS_READ) != BL_SUCCESS)
+      continue;
+    entries[std::move(key)] = std::move(cached);
+  }
+}
+
+std::optional<BLImage> DiskCache::find(const std::string &cache_key,
+                                       const std::string &source) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = entries.find(cache_key);
+  if (it == entries.end() || it->second.source != source)
+    return std::nullopt;
+  if (get_mtime(source) != it->second.mtime)
+    return std::nullopt;
+  it->second.used = true;
+  return it->second.image;
+}
+
+void DiskCache::store(const std::string &cache_key, const std::string &source,
+                      const BLImage &image) {
+  auto mtime = get_mtime(source);
+  if (!mtime || image.empty())
+    return;
+
+  Entry entry;
+  entry.source = source;
+  entry.mtime = *mtime;
+  entry.used = true;
+  if (image.format() == BL_FORMAT_PRGB32) {
+    entry.image = image;
+  } else {
+    entry.image.create(image.width(), image.height(), BL_FORMAT_PRGB32);
+    BLContext ctx(entry.image);
+    ctx.set_comp_op(BL_COMP_OP_SRC_COPY);
+    ctx.blit_image(BLPointI(0, 0), image);
+    ctx.end();
+  }
+
+  std::lock_guard<std::mutex> lock(mutex);
+  entries[cache_key] = std::move(entry);
+  dirty = true;
+}
+
+void DiskCache::save() {
+  std::lock_guard<std::mutex> save_lock(save_mutex);
+
+  // images share their pixels, so the snapshot is cheap and the file is
+  // written without holding the lock
+  std::string chain;
+  std::vector<std::pair<std::string, Entry>> snapshot;
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (!dirty)
+      return;
+    dirty = false;
+    chain = theme_chain;
+    for (const auto &[key, entry] : entries) {
+      uint32_t unused_runs = entry.used ? 0 : entry.unused_runs + 1;
+      if (unused_runs > MAX_UNUSED_RUNS)
+        continue;
+      snapshot.emplace_back(key, entry);
+      snapshot.back().second.unused_runs = unused_runs;
+    }
+  }
+
+  fs::path cache_file = get_cache_path();
+  std::error_code ec;
+  fs::create_directories(cache_file.parent_path(), ec);
+
+  FileHeader header;
+  std::memcpy(header.magic, CACHE_MAGIC, sizeof(CACHE_MAGIC));
+  header.version = CACHE_VERSION;
+  header.entry_count = snapshot.size();
+  header.chain_length = chain.size();
+
+  uint64_t pixel_offset = sizeof(header) + chain.size();
+  for (const auto &[key, entry] : snapshot) {
+    pixel_offset += sizeof(EntryHeader) + key.size() + entry.source.size();
+  }
+
+  std::string file;
+  file.reserve(pixel_offset);
+  file.append((const char *)&header, sizeof(header));
+  file.append(chain);
+
+  std::vector<BLImageData> pixels(snapshot.size());
+  for (size_t i = 0; i < snapshot.size(); ++i) {
+    const auto &[key, entry] = snapshot[i];
+    entry.image.get_data(&pixels[i]);
+
+    EntryHeader eh{};
+    eh.key_length = key.size();
+    eh.source_length = entry.source.size();
+    eh.mtime = entry.mtime;
+    eh.unused_runs = entry.unused_runs;
+    eh.width = pixels[i].size.w;
+    eh.height = pixels[i].size.h;
+    eh.stride = (uint32_t)pixels[i].size.w * 4;
+    pixel_offset = align_up(pixel_offset);
+    eh.pixel_offset = pixel_offset;
+    pixel_offset += (uint64_t)eh.stride * eh.height;
+
+    file.append((const char *)&eh, sizeof(eh));
+    file.append(key);
+    file.append(entry.source);
+  }
+
+  for (const auto &data : pixels) {
+    file.resize(align_up(file.size()), '\0');
+
+    size_t row_size = (size_t)data.size.w * 4;
+    for (int y = 0; y < data.size.h; ++y) {
+      file.append((const char *)data.pixel_data + y * data.stride, row_size);
+    }
+  }
+
+  // the old file stays mapped until the next start, renaming leaves it be
+  if (!Lawnch::Fs::write_file_atomic(cache_file, file)) {
+    Lawnch::Logger::log("IconCache", Lawnch::Logger::LogLevel::ERROR,
+                        "Failed to write icon cache file.");
+  }
+}
+
+} // namespace Lawnch::Core::Icons
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <blend2d.h>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+
+namespace Lawnch::Core::Icons {
+
+// Rasterized icons kept across runs in ~/.cache/lawnch/icons.cache as
+// premultiplied BGRA tiles. The file is mapped and icons read from it are
+// BLImages over the mapped pixels, so nothing is decoded on a warm start.
+class DiskCache {
+public:
+  DiskCache() = default;
+  ~DiskCache();
+  DiskCache(const DiskCache &) = delete;
+  DiskCache &operator=(const DiskCache &) = delete;
+
+  // Maps the cache file, ignoring it unless it was written for the same
+  // theme chain. Images handed out earlier must be gone by now.
+  void open(const std::string &theme_chain);
+
+  // The icon stored under `cache_key`, provided it was rasterized from
+  // `source` and the file has not changed since.
+  std::optional<BLImage> find(const std::string &cache_key,
+                              const std::string &source);
+  void store(const std::string &cache_key, const std::string &source,
+             const BLImage &image);
+
+  // Rewrites the file when icons were stored since the last save. Icons
+  // nobody asked for in a few runs are left out.
+  void save();
+
+private:
+  struct Entry {
+    std::string source;
+    int64_t mtime = 0;
+    BLImage image;
+    uint32_t unused_runs = 0; // saves in a row it was not used before
+    bool used = false;        // found or stored this run
+  };
+
+  void close();
+
+  std::mutex mutex;
+  std::mutex save_mutex; // an older snapshot never lands after a newer one
+  std::string theme_chain;
+  void *mapping = nullptr;
+  size_t mapping_size = 0;
+  std::unordered_map<std::string, Entry> entries;
+  bool dirty = false;
+};
+
+} // namespace Lawnch::Core::Icons
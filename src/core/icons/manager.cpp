@@ -1,4 +1,5 @@
 #include "manager.hpp"
+#include "../../helpers/gfx.hpp"
 #include "../../helpers/logger.hpp"
 #include "../config/manager.hpp"
 #include <algorithm>
@@ -13,17 +14,31 @@
 
 namespace Lawnch::Core::Icons {
 
+// translucent grey drawn where an icon is still loading
+static constexpr uint32_t PLACEHOLDER_COLOR = 0x30808080;
+
 Manager &Manager::Instance() {
   static Manager instance;
   return instance;
 }
 
-Manager::Manager() {}
+Manager::Manager() {
+  unsigned count =
+      std::clamp(std::thread::hardware_concurrency() / 2, 1u, 4u);
+  for (unsigned i = 0; i < count; ++i) {
+    workers.emplace_back(&Manager::worker_loop, this);
+  }
+}
 
 Manager::~Manager() {
-  for (auto &pair : cache) {
-    if (pair.second)
-      nsvgDelete(pair.second);
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    running = false;
+  }
+  queue_cv.notify_all();
+  for (auto &worker : workers) {
+    if (worker.joinable())
+      worker.join();
   }
 }
 
@@ -44,6 +59,12 @@ void Manager::init() {
     Lawnch::Logger::log("IconManager", Lawnch::Logger::LogLevel::ERROR,
                         "Failed to init theme loader");
   }
+  {
+    std::lock_guard<std::mutex> lock(mutex);
+    missing_icons.clear();
+    atlas.clear();
+  }
+  disk_cache.open(theme_loader.get_theme_chain());
   initialized = true;
 }
 
@@ -53,8 +74,111 @@ void Manager::ensure_initialized() {
   }
 }
 
-bool Manager::load_icon_image(const std::string &path,
-                              const std::string &cache_key, double size) {
+void Manager::set_render_callback(std::function<void()> cb) {
+  std::lock_guard<std::mutex> lock(mutex);
+  render_callback = std::move(cb);
+}
+
+void Manager::begin_frame() {
+  std::lock_guard<std::mutex> lock(mutex);
+  frame++;
+}
+
+bool Manager::take_loaded() {
+  std::lock_guard<std::mutex> lock(mutex);
+  bool was_loaded = loaded;
+  loaded = false;
+  return was_loaded;
+}
+
+void Manager::worker_loop() {
+  while (true) {
+    Job job;
+
+    {
+      std::unique_lock<std::mutex> lock(mutex);
+      queue_cv.wait(lock, [this] { return !job_queue.empty() || !running; });
+
+      if (!running)
+        return;
+
+      auto it = job_queue.begin();
+      job = std::move(it->second);
+      job_queue.erase(it);
+      queued.erase(job.cache_key);
+      in_flight.insert(job.cache_key);
+    }
+
+    // stats the source, which is why it is not done while rendering
+    auto image = disk_cache.find(job.cache_key, job.path);
+    if (!image) {
+      // stored at the size it is drawn, a warm start resamples nothing
+      image = load_icon_image(job.path, job.size);
+      if (image) {
+        *image = Atlas::fit(*image, (int)job.size);
+        disk_cache.store(job.cache_key, job.path, *image);
+      }
+    }
+
+    bool idle;
+    bool needs_source;
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      in_flight.erase(job.cache_key);
+      Atlas::Slot slot;
+      if (!image || !atlas.insert(job.cache_key, (int)job.size, *image, slot))
+        missing_icons.insert(job.cache_key);
+      // either way the placeholder has to go
+      loaded = true;
+      if (render_callback)
+        render_callback();
+      idle = job_queue.empty() && in_flight.empty();
+      // other sizes of this file still queued keep it parsed, workers
+      // rasterizing it hold their own reference
+      needs_source = std::any_of(
+          job_queue.begin(), job_queue.end(),
+          [&](const auto &queued_job) {
+            return queued_job.second.path == job.path;
+          });
+    }
+
+    if (!needs_source)
+      release_svg(job.path);
+
+    // persist once the burst of loads is over
+    if (idle)
+      disk_cache.save();
+  }
+}
+
+std::shared_ptr<NSVGimage> Manager::get_svg(const std::string &path) {
+  std::lock_guard<std::mutex> lock(svg_mutex);
+  auto it = cache.find(path);
+  if (it != cache.end())
+    return it->second;
+
+  NSVGimage *parsed = nsvgParseFromFile(path.c_str(), "px", 96.0f);
+  if (!parsed)
+    return nullptr;
+  std::shared_ptr<NSVGimage> image(parsed, nsvgDelete);
+  cache[path] = image;
+  return image;
+}
+
+void Manager::release_svg(const std::string &path) {
+  std::lock_guard<std::mutex> lock(svg_mutex);
+  cache.erase(path);
+}
+
+NSVGrasterizer *Manager::get_rasterizer() {
+  // one per worker, reused for every icon it rasterizes
+  thread_local std::unique_ptr<NSVGrasterizer, void (*)(NSVGrasterizer *)>
+      rasterizer(nsvgCreateRasterizer(), nsvgDeleteRasterizer);
+  return rasterizer.get();
+}
+
+std::optional<BLImage> Manager::load_icon_image(const std::string &path,
+                                                double size) {
 
   if (path.find(".png") != std::string::npos ||
       path.find(".jpg") != std::string::npos ||
@@ -62,31 +186,21 @@ bool Manager::load_icon_image(const std::string &path,
     BLImage img;
     BLResult err = img.read_from_file(path.c_str());
     if (err == BL_SUCCESS) {
-      icon_cache[cache_key] = img;
-      return true;
+      return img;
     }
     Lawnch::Logger::log("IconManager", Lawnch::Logger::LogLevel::ERROR,
                         "Blend2D failed to load: " + path);
-    return false;
+    return std::nullopt;
   }
 
   if (path.find(".svg") != std::string::npos) {
-    NSVGimage *image = nullptr;
-
-    if (cache.find(path) != cache.end()) {
-      image = cache[path];
-    } else {
-      image = nsvgParseFromFile(path.c_str(), "px", 96.0f);
-      if (image)
-        cache[path] = image;
-    }
-
+    std::shared_ptr<NSVGimage> image = get_svg(path);
     if (!image)
-      return false;
+      return std::nullopt;
 
-    NSVGrasterizer *rast = nsvgCreateRasterizer();
+    NSVGrasterizer *rast = get_rasterizer();
     if (rast == NULL)
-      return false;
+      return std::nullopt;
 
     int w = (int)size;
     int h = (int)size;
@@ -98,49 +212,24 @@ bool Manager::load_icon_image(const std::string &path,
     float tx = std::round((size - (image->width * scale)) * 0.5f);
     float ty = std::round((size - (image->height * scale)) * 0.5f);
 
-    int stride = w * 4;
-    std::vector<unsigned char> temp_buffer(stride * h, 0);
-
-    nsvgRasterize(rast, image, tx, ty, scale, temp_buffer.data(), w, h, stride);
-    nsvgDeleteRasterizer(rast);
-
+    // nanosvg clears and fills the image memory itself, then the pixels
+    // are turned into premultiplied BGRA in place
     BLImage img(w, h, BL_FORMAT_PRGB32);
     BLImageData imgData;
-    img.make_mutable(&imgData);
-
-    unsigned char *blData = (unsigned char *)imgData.pixel_data;
-    int blStride = imgData.stride;
-    const unsigned char *srcData = temp_buffer.data();
+    if (img.make_mutable(&imgData) != BL_SUCCESS)
+      return std::nullopt;
 
+    auto *blData = static_cast<unsigned char *>(imgData.pixel_data);
+    nsvgRasterize(rast, image.get(), tx, ty, scale, blData, w, h,
+                  (int)imgData.stride);
     for (int iy = 0; iy < h; ++iy) {
-      const unsigned char *srcRow = srcData + iy * stride;
-      unsigned char *dstRow = blData + iy * blStride;
-      for (int ix = 0; ix < w; ++ix) {
-        unsigned int r = srcRow[ix * 4 + 0];
-        unsigned int g = srcRow[ix * 4 + 1];
-        unsigned int b = srcRow[ix * 4 + 2];
-        unsigned int a = srcRow[ix * 4 + 3];
-
-        if (a > 0) {
-          // pre-multiply alpha
-          r = (r * a + 127) / 255;
-          g = (g * a + 127) / 255;
-          b = (b * a + 127) / 255;
-          dstRow[ix * 4 + 0] = (unsigned char)b; // Blue
-          dstRow[ix * 4 + 1] = (unsigned char)g; // Green
-          dstRow[ix * 4 + 2] = (unsigned char)r; // Red
-          dstRow[ix * 4 + 3] = (unsigned char)a; // Alpha
-        } else {
-          *((uint32_t *)&dstRow[ix * 4]) = 0;
-        }
-      }
+      Lawnch::Gfx::rgba_to_prgb32(blData + iy * imgData.stride, w);
     }
 
-    icon_cache[cache_key] = img;
-    return true;
+    return img;
   }
 
-  return false;
+  return std::nullopt;
 }
 
 void Manager::render_icon(BLContext &ctx, const std::string &icon_name,
@@ -152,21 +241,50 @@ void Manager::render_icon(BLContext &ctx, const std::string &icon_name,
 
   std::string cache_key = icon_name + "_" + std::to_string((int)size);
 
-  if (icon_cache.find(cache_key) != icon_cache.end()) {
-    ctx.blit_image(BLPoint(std::floor(x), std::floor(y)),
-                   icon_cache[cache_key]);
-    return;
-  }
-
-  std::string path = theme_loader.lookup_icon(icon_name);
-  if (path.empty()) {
-    return;
+  // centered in the size x size box it was scaled to fit
+  auto draw_slot = [&](const Atlas::Slot &slot) {
+    BLPointI at((int)std::floor(x + (size - slot.area.w) / 2.0),
+                (int)std::floor(y + (size - slot.area.h) / 2.0));
+    ctx.blit_image(at, *slot.page, slot.area);
+  };
+
+  {
+    // held while blitting, workers pack new icons into the same pages
+    std::lock_guard<std::mutex> lock(mutex);
+    Atlas::Slot slot;
+    if (atlas.find(cache_key, slot)) {
+      draw_slot(slot);
+      return;
+    }
+    if (missing_icons.count(cache_key))
+      return;
+
+    JobOrder order{UINT64_MAX - frame, next_request++};
+    auto pending = queued.find(cache_key);
+    if (pending != queued.end()) {
+      // still on screen, move it up with the rest of this frame
+      if (pending->second.first != order.first) {
+        auto node = job_queue.extract(pending->second);
+        node.key() = order;
+        job_queue.insert(std::move(node));
+        pending->second = order;
+      }
+    } else if (!in_flight.count(cache_key)) {
+      std::string path = theme_loader.lookup_icon(icon_name, (int)size);
+      if (path.empty()) {
+        missing_icons.insert(cache_key);
+        return;
+      }
+      job_queue.emplace(order, Job{path, cache_key, size});
+      queued.emplace(cache_key, order);
+      queue_cv.notify_one();
+    }
   }
 
-  if (load_icon_image(path, cache_key, size)) {
-    ctx.blit_image(BLPoint(std::floor(x), std::floor(y)),
-                   icon_cache[cache_key]);
-  }
+  // cheap stand-in until the worker is done
+  ctx.fill_round_rect(
+      BLRoundRect(std::floor(x), std::floor(y), size, size, size * 0.2),
+      BLRgba32(PLACEHOLDER_COLOR));
 }
 
 } // namespace Lawnch::Core::Icons
@@ -1,12 +1,24 @@
 #pragma once
 
+#include "atlas.hpp"
+#include "disk_cache.hpp"
 #include "theme_loader.hpp"
 #include <blend2d.h>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <map>
 #include <memory>
+#include <mutex>
+#include <optional>
 #include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 struct NSVGimage;
+struct NSVGrasterizer;
 
 namespace Lawnch::Core::Icons {
 
@@ -14,24 +26,68 @@ class Manager {
 public:
   static Manager &Instance();
 
+  // Draws the icon if it is loaded. Otherwise queues it for the workers and
+  // draws a placeholder; the render callback fires once it is ready.
   void render_icon(BLContext &ctx, const std::string &icon_name, double x,
                    double y, double size);
 
+  // Icons requested since the last call were on screen in the newest frame
+  // and are loaded before anything asked for earlier.
+  void begin_frame();
+
+  void set_render_callback(std::function<void()> cb);
+  // true once after icons finished loading in the background
+  bool take_loaded();
+
 private:
   Manager();
   ~Manager();
+  Manager(const Manager &) = delete;
+  Manager &operator=(const Manager &) = delete;
 
   void init();
   void ensure_initialized();
 
-  bool load_icon_image(const std::string &path, const std::string &cache_key,
-                       double size);
+  std::optional<BLImage> load_icon_image(const std::string &path,
+                                         double size);
+  std::shared_ptr<NSVGimage> get_svg(const std::string &path);
+  void release_svg(const std::string &path);
+  static NSVGrasterizer *get_rasterizer();
+  void worker_loop();
 
   bool initialized = false;
   ThemeLoader theme_loader;
 
-  std::map<std::string, NSVGimage *> cache;
-  std::map<std::string, BLImage> icon_cache;
+  // parsed svgs, kept only while a job for another size of them is queued
+  std::mutex svg_mutex;
+  std::map<std::string, std::shared_ptr<NSVGimage>> cache;
+
+  struct Job {
+    std::string path;
+    std::string cache_key;
+    double size;
+  };
+
+  // ordered by (newest frame first, then request order)
+  using JobOrder = std::pair<uint64_t, uint64_t>;
+
+  std::mutex mutex;
+  std::condition_variable queue_cv;
+  std::vector<std::thread> workers;
+  bool running = true;
+  bool loaded = false;
+  uint64_t frame = 0;
+  uint64_t next_request = 0;
+  std::map<JobOrder, Job> job_queue;
+  std::unordered_map<std::string, JobOrder> queued;
+  std::unordered_set<std::string> in_flight;
+  std::function<void()> render_callback;
+
+  // icons rasterized by earlier runs
+  DiskCache disk_cache;
+  Atlas atlas;
+  // cache keys that have no icon or failed to load, not looked up again
+  std::unordered_set<std::string> missing_icons;
 };
 
 } // namespace Lawnch::Core::Icons
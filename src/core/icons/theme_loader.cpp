@@ -2,10 +2,12 @@
 #include "../../helpers/fs.hpp"
 #include "../../helpers/logger.hpp"
 #include <algorithm>
+#include <climits>
 #include <cstdlib>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <map>
 #include <set>
 #include <sstream>
 
@@ -20,25 +22,102 @@ namespace Lawnch::Core::Icons {
 struct ThemeParseState {
   std::string inherits;
   std::string directories;
+  std::string scaled_directories;
+  // every other section describes a directory, MinSize and MaxSize stay
+  // negative until set
+  std::map<std::string, IconDir> dirs;
 };
 
+static int parse_int(const char *value, int fallback) {
+  try {
+    return std::stoi(value);
+  } catch (...) {
+    return fallback;
+  }
+}
+
 static int theme_ini_handler(void *user, const char *section, const char *name,
                              const char *value) {
   ThemeParseState *state = (ThemeParseState *)user;
 
-  // We only care about the [Icon Theme] section
   std::string sec(section);
+  std::string key(name);
   if (sec == "Icon Theme") {
-    std::string key(name);
     if (key == "Inherits") {
       state->inherits = value;
     } else if (key == "Directories") {
       state->directories = value;
+    } else if (key == "ScaledDirectories") {
+      state->scaled_directories = value;
     }
+    return 1;
+  }
+
+  auto [it, inserted] = state->dirs.try_emplace(sec);
+  IconDir &dir = it->second;
+  if (inserted) {
+    dir.path = sec;
+    dir.min_size = dir.max_size = -1;
+  }
+
+  if (key == "Size") {
+    dir.size = parse_int(value, dir.size);
+  } else if (key == "MinSize") {
+    dir.min_size = parse_int(value, dir.min_size);
+  } else if (key == "MaxSize") {
+    dir.max_size = parse_int(value, dir.max_size);
+  } else if (key == "Scale") {
+    dir.scale = parse_int(value, dir.scale);
+  } else if (key == "Threshold") {
+    dir.threshold = parse_int(value, dir.threshold);
+  } else if (key == "Type") {
+    std::string type(value);
+    if (type == "Fixed")
+      dir.type = IconDirType::Fixed;
+    else if (type == "Scalable")
+      dir.type = IconDirType::Scalable;
+    else
+      dir.type = IconDirType::Threshold;
   }
   return 1;
 }
 
+static bool directory_matches_size(const IconDir &dir, int size, int scale) {
+  if (dir.scale != scale)
+    return false;
+  switch (dir.type) {
+  case IconDirType::Fixed:
+    return dir.size == size;
+  case IconDirType::Scalable:
+    return dir.min_size <= size && size <= dir.max_size;
+  case IconDirType::Threshold:
+    return dir.size - dir.threshold <= size &&
+           size <= dir.size + dir.threshold;
+  }
+  return false;
+}
+
+static int directory_size_distance(const IconDir &dir, int size, int scale) {
+  int scaled = size * scale;
+  switch (dir.type) {
+  case IconDirType::Fixed:
+    return std::abs(dir.size * dir.scale - scaled);
+  case IconDirType::Scalable:
+    if (scaled < dir.min_size * dir.scale)
+      return dir.min_size * dir.scale - scaled;
+    if (scaled > dir.max_size * dir.scale)
+      return scaled - dir.max_size * dir.scale;
+    return 0;
+  case IconDirType::Threshold:
+    if (scaled < (dir.size - dir.threshold) * dir.scale)
+      return dir.min_size * dir.scale - scaled;
+    if (scaled > (dir.size + dir.threshold) * dir.scale)
+      return scaled - dir.max_size * dir.scale;
+    return 0;
+  }
+  return 0;
+}
+
 struct ConfigFindState {
   std::string target_section;
   std::string target_key;
@@ -93,10 +172,22 @@ bool ThemeLoader::init() {
     load_theme_recursive("hicolor", visited);
   }
 
+  build_index();
+
   initialized = true;
   return true;
 }
 
+std::string ThemeLoader::get_theme_chain() const {
+  std::string chain;
+  for (const auto &theme : active_theme_stack) {
+    if (!chain.empty())
+      chain += ',';
+    chain += theme.name;
+  }
+  return chain;
+}
+
 void ThemeLoader::ensure_initialized() {
   if (!initialized) {
     init();
@@ -139,13 +230,28 @@ bool ThemeLoader::load_theme_definition(const std::string &theme_name,
       }
 
       out_theme.inherits = split_string(state.inherits, ',');
-      out_theme.subdirs = split_string(state.directories, ',');
 
       for (auto &s : out_theme.inherits) {
         s.erase(0, s.find_first_not_of(" \t"));
         s.erase(s.find_last_not_of(" \t") + 1);
       }
 
+      auto subdirs = split_string(state.directories, ',');
+      auto scaled = split_string(state.scaled_directories, ',');
+      subdirs.insert(subdirs.end(), scaled.begin(), scaled.end());
+      for (const auto &subdir : subdirs) {
+        IconDir dir;
+        auto it = state.dirs.find(subdir);
+        if (it != state.dirs.end())
+          dir = it->second;
+        dir.path = subdir;
+        if (dir.min_size < 0)
+          dir.min_size = dir.size;
+        if (dir.max_size < 0)
+          dir.max_size = dir.size;
+        out_theme.subdirs.push_back(dir);
+      }
+
       return true; // Found and loaded
     }
   }
@@ -188,12 +294,14 @@ std::string ThemeLoader::detect_system_theme() {
   return "hicolor";
 }
 
-std::string ThemeLoader::lookup_icon(const std::string &icon_name) {
+std::string ThemeLoader::lookup_icon(const std::string &icon_name, int size,
+                                     int scale) {
   ensure_initialized();
-  return find_icon_path(icon_name);
+  return find_icon_path(icon_name, size, scale);
 }
 
-std::string ThemeLoader::find_icon_path(const std::string &name) {
+std::string ThemeLoader::find_icon_path(const std::string &name, int size,
+                                        int scale) {
   if (name.empty())
     return "";
   // don't evaluate furthermore, it is a path not icon name
@@ -201,39 +309,182 @@ std::string ThemeLoader::find_icon_path(const std::string &name) {
     return "";
   }
 
-  for (const auto &theme : active_theme_stack) {
+  auto it = icon_index.find(name);
+  if (it == icon_index.end())
+    return "";
 
-    for (const auto &subdir : theme.subdirs) {
-      fs::path dir = fs::path(theme.full_path) / subdir;
+  // files are grouped by theme, a theme that has the icon at any size wins
+  // over its parents. Unsized hits (theme roots, pixmaps) are the fallback
+  // once no theme in the chain has a sized one, as in the freedesktop spec.
+  const auto &files = it->second;
+  const IconFile *unsized = nullptr;
+  size_t i = 0;
+  while (i < files.size()) {
+    size_t theme = lookup_dirs[files[i].dir].theme;
+    const IconFile *exact = nullptr;
+    const IconFile *closest = nullptr;
+    int closest_distance = INT_MAX;
+
+    for (; i < files.size() && lookup_dirs[files[i].dir].theme == theme; ++i) {
+      const LookupDir &dir = lookup_dirs[files[i].dir];
+      if (!dir.sized) {
+        if (!unsized)
+          unsized = &files[i];
+        continue;
+      }
 
-      std::vector<fs::path> candidates;
-      candidates.push_back(dir / (name + ".svg"));
-      candidates.push_back(dir / (name + ".png"));
+      // a bitmap drawn for this very size beats scaling an svg
+      if (directory_matches_size(dir.info, size, scale) &&
+          (!exact || (lookup_dirs[exact->dir].info.type ==
+                          IconDirType::Scalable &&
+                      dir.info.type != IconDirType::Scalable))) {
+        exact = &files[i];
+      }
 
-      for (const auto &p : candidates) {
-        if (fs::exists(p))
-          return p.string();
+      int distance = directory_size_distance(dir.info, size, scale);
+      if (distance < closest_distance) {
+        closest_distance = distance;
+        closest = &files[i];
       }
     }
 
-    fs::path root_svg = fs::path(theme.full_path) / (name + ".svg");
-    if (fs::exists(root_svg))
-      return root_svg.string();
+    if (exact)
+      return exact->path;
+    if (closest)
+      return closest->path;
+  }
+
+  return unsized ? unsized->path : "";
+}
 
-    fs::path root_png = fs::path(theme.full_path) / (name + ".png");
-    if (fs::exists(root_png))
-      return root_png.string();
+std::vector<ThemeLoader::LookupDir> ThemeLoader::get_lookup_dirs() const {
+  std::vector<LookupDir> dirs;
+  size_t theme_index = 0;
+  for (const auto &theme : active_theme_stack) {
+    for (const auto &subdir : theme.subdirs) {
+      dirs.push_back({(fs::path(theme.full_path) / subdir.path).string(),
+                      theme_index, true, subdir});
+    }
+    dirs.push_back({theme.full_path, theme_index, false, {}});
+    theme_index++;
   }
 
   // Fallback /usr/share/pixmaps
-  fs::path pixmap = fs::path("/usr/share/pixmaps") / (name + ".svg");
-  if (fs::exists(pixmap))
-    return pixmap.string();
-  pixmap = fs::path("/usr/share/pixmaps") / (name + ".png");
-  if (fs::exists(pixmap))
-    return pixmap.string();
-
-  return "";
+  dirs.push_back({"/usr/share/pixmaps", theme_index, false, {}});
+  return dirs;
+}
+
+// bumped whenever the cache file layout changes
+static constexpr int ICON_INDEX_VERSION = 2;
+
+// Adding or removing an icon touches the directory it lives in, so the
+// directories and their mtimes are enough to tell a stale index apart.
+std::string ThemeLoader::get_index_signature() const {
+  std::string signature = "VERSION=" + std::to_string(ICON_INDEX_VERSION) + ";";
+  for (const auto &lookup_dir : lookup_dirs) {
+    const std::string &dir = lookup_dir.path;
+    std::error_code ec;
+    auto mtime = fs::last_write_time(dir, ec);
+    signature += dir;
+    signature += '=';
+    signature +=
+        ec ? "-" : std::to_string(mtime.time_since_epoch().count());
+    signature += ';';
+  }
+  return signature;
+}
+
+void ThemeLoader::build_index() {
+  icon_index.clear();
+
+  lookup_dirs = get_lookup_dirs();
+  std::string signature = get_index_signature();
+  if (load_index_cache(signature))
+    return;
+
+  // one listing per directory instead of a stat per icon and directory
+  for (uint32_t i = 0; i < lookup_dirs.size(); ++i) {
+    const std::string &dir = lookup_dirs[i].path;
+    std::error_code ec;
+    std::vector<fs::path> svgs, pngs;
+    for (fs::directory_iterator it(dir, ec), end; !ec && it != end;
+         it.increment(ec)) {
+      const fs::path &p = it->path();
+      if (p.extension() == ".svg")
+        svgs.push_back(p);
+      else if (p.extension() == ".png")
+        pngs.push_back(p);
+    }
+
+    // within a directory svg wins over png
+    for (const auto *files : {&svgs, &pngs}) {
+      for (const auto &p : *files) {
+        icon_index[p.stem().string()].push_back({i, p.string()});
+      }
+    }
+  }
+
+  save_index_cache(signature);
+}
+
+static fs::path get_index_cache_path() {
+  return ::Lawnch::Fs::get_cache_home() / "lawnch" / "icon-index.cache";
+}
+
+bool ThemeLoader::load_index_cache(const std::string &signature) {
+  std::ifstream file(get_index_cache_path());
+  if (!file.is_open())
+    return false;
+
+  std::string line;
+  if (!std::getline(file, line) || line != "SIGNATURE:" + signature)
+    return false;
+
+  // only a file that made it to the END line is complete
+  decltype(icon_index) loaded;
+  std::vector<IconFile> *files = nullptr;
+  while (std::getline(file, line)) {
+    if (line.rfind("END:", 0) == 0) {
+      if (parse_int(line.substr(4).c_str(), -1) != (int)loaded.size())
+        return false;
+      icon_index = std::move(loaded);
+      return true;
+    } else if (line.rfind("ICON:", 0) == 0) {
+      files = &loaded[line.substr(5)];
+    } else if (line.rfind("PATH:", 0) == 0 && files) {
+      // PATH:<lookup dir>:<path>
+      size_t sep = line.find(':', 5);
+      if (sep == std::string::npos)
+        continue;
+      uint32_t dir = (uint32_t)parse_int(line.substr(5, sep - 5).c_str(), -1);
+      if (dir >= lookup_dirs.size())
+        continue;
+      files->push_back({dir, line.substr(sep + 1)});
+    }
+  }
+  return false;
+}
+
+void ThemeLoader::save_index_cache(const std::string &signature) {
+  fs::path cache_file = get_index_cache_path();
+  std::error_code ec;
+  fs::create_directories(cache_file.parent_path(), ec);
+
+  std::ostringstream file;
+  file << "SIGNATURE:" << signature << "\n";
+  for (const auto &[name, files] : icon_index) {
+    file << "ICON:" << name << "\n";
+    for (const auto &icon_file : files) {
+      file << "PATH:" << icon_file.dir << ":" << icon_file.path << "\n";
+    }
+  }
+  file << "END:" << icon_index.size() << "\n";
+
+  // renamed into place, another instance never reads half of it
+  if (!::Lawnch::Fs::write_file_atomic(cache_file, file.str())) {
+    ::Lawnch::Logger::log("ThemeLoader", ::Lawnch::Logger::LogLevel::ERROR,
+                          "Failed to write icon index cache.");
+  }
 }
 
 std::vector<std::string> ThemeLoader::split_string(const std::string &str,
@@ -1,15 +1,31 @@
 #pragma once
 
+#include <cstdint>
 #include <list>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 namespace Lawnch::Core::Icons {
 
+enum class IconDirType { Fixed, Scalable, Threshold };
+
+// One of the directories listed in index.theme, along with the sizes its
+// icons are meant for.
+struct IconDir {
+  std::string path; // relative to the theme
+  int size = 0;
+  int min_size = 0;
+  int max_size = 0;
+  int scale = 1;
+  int threshold = 2;
+  IconDirType type = IconDirType::Threshold;
+};
+
 struct IconTheme {
   std::string name;
   std::string full_path;
-  std::vector<std::string> subdirs;
+  std::vector<IconDir> subdirs;
   std::vector<std::string> inherits;
 };
 
@@ -18,8 +34,14 @@ public:
   ThemeLoader();
   ~ThemeLoader();
 
-  std::string lookup_icon(const std::string &icon_name);
+  // The file closest to `size` (in logical pixels) following the freedesktop
+  // icon lookup: an exact size match in the first theme that has the icon,
+  // else the closest size in that theme, then its parents.
+  std::string lookup_icon(const std::string &icon_name, int size,
+                          int scale = 1);
   void set_custom_theme(const std::string &name);
+  // names of the loaded theme and everything it inherits, in lookup order
+  std::string get_theme_chain() const;
   bool init();
 
 private:
@@ -30,12 +52,33 @@ private:
   std::vector<std::string> base_search_paths;
   std::list<IconTheme> active_theme_stack;
 
+  struct LookupDir {
+    std::string path;
+    size_t theme = 0; // position in the theme stack
+    bool sized = false;
+    IconDir info;
+  };
+
+  struct IconFile {
+    uint32_t dir = 0; // into lookup_dirs
+    std::string path;
+  };
+
+  std::vector<LookupDir> lookup_dirs;
+  // icon name -> every file with that name, in lookup order
+  std::unordered_map<std::string, std::vector<IconFile>> icon_index;
+
   void load_theme_recursive(const std::string &theme_name,
                             std::vector<std::string> &visited);
   bool load_theme_definition(const std::string &theme_name,
                              IconTheme &out_theme);
   std::string detect_system_theme();
-  std::string find_icon_path(const std::string &name);
+  std::string find_icon_path(const std::string &name, int size, int scale);
+  std::vector<LookupDir> get_lookup_dirs() const;
+  std::string get_index_signature() const;
+  void build_index();
+  bool load_index_cache(const std::string &signature);
+  void save_index_cache(const std::string &signature);
   std::vector<std::string> split_string(const std::string &str, char delimiter);
 };
 
@@ -138,6 +138,8 @@ std::vector<SearchResult> Engine::query(const std::string &term) {
   if (term.empty())
     return {};
 
+  plugin_manager.preload_for_prefix(term);
+
   if (auto *plugin = plugin_manager.find_plugin_for_query(term, sub_query)) {
     results = plugin->query(sub_query);
     sort_results(results);
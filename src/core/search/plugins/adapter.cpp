@@ -1,4 +1,5 @@
 #include "adapter.hpp"
+#include "lawnch_host_ext.h"
 
 namespace Lawnch::Core::Search::Plugins {
 
@@ -8,6 +9,20 @@ Adapter::Adapter(LawnchPluginVTable *vt) : vtable(vt) {
   }
 }
 
+void Adapter::set_cache_policy(int policy) {
+  if (policy < LAWNCH_CACHE_POLICY_NONE ||
+      policy > LAWNCH_CACHE_POLICY_INVALIDATE_ON_EVENT)
+    policy = LAWNCH_CACHE_POLICY_NONE;
+  result_cache.clear();
+  result_cache.set_ttl(std::chrono::milliseconds(
+      policy == LAWNCH_CACHE_POLICY_TTL ? LAWNCH_CACHE_DEFAULT_TTL_MS : 0));
+  cache_policy = policy;
+}
+
+bool Adapter::is_cached() const {
+  return cache_policy != LAWNCH_CACHE_POLICY_NONE;
+}
+
 bool Adapter::allow_history() const {
   return !(flags & LAWNCH_PLUGIN_FLAG_DISABLE_HISTORY);
 }
@@ -79,9 +94,34 @@ SearchResult Adapter::get_help() const {
 
 std::vector<SearchResult> Adapter::query(const std::string &term) {
   std::vector<SearchResult> results;
+  if (collection.is_registered()) {
+    // with history the engine re-ranks by usage and truncates afterwards,
+    // cutting here would drop often used items that match less well
+    auto start = std::chrono::steady_clock::now();
+    results = collection.query(term, !allow_history());
+    stats.record_query(std::chrono::steady_clock::now() - start,
+                       results.size());
+    for (auto &r : results) {
+      r.track_history = allow_history();
+      r.use_custom_sort = is_custom_sorted();
+    }
+    return results;
+  }
+
+  std::string cache_key;
+  if (is_cached()) {
+    cache_key = "q:" + term;
+    if (auto cached = result_cache.get(cache_key))
+      return std::move(*cached);
+  }
+
   if (vtable && vtable->query) {
     int count = 0;
+    // taken first, an invalidate() while the plugin runs wins
+    uint64_t generation = result_cache.generation();
+    auto start = std::chrono::steady_clock::now();
     LawnchResult *res = vtable->query(term.c_str(), &count);
+    auto elapsed = std::chrono::steady_clock::now() - start;
     results.reserve(count);
     for (int i = 0; i < count; ++i) {
       SearchResult sr{res[i].name ? res[i].name : "",
@@ -105,6 +145,10 @@ std::vector<SearchResult> Adapter::query(const std::string &term) {
     if (vtable->free_results) {
       vtable->free_results(res, count);
     }
+    scratch.reset();
+    stats.record_query(elapsed, results.size());
+    if (is_cached())
+      result_cache.put(cache_key, results, generation);
   }
   return results;
 }
@@ -114,10 +158,21 @@ Adapter::query_submenu(const std::string &result_command,
                        const std::string &term) {
   std::vector<SearchResult> results;
 #if LAWNCH_PLUGIN_API_VERSION >= 1
+  std::string cache_key;
+  if (is_cached()) {
+    cache_key = "s:" + result_command + '\0' + term;
+    if (auto cached = result_cache.get(cache_key))
+      return std::move(*cached);
+  }
+
   if (vtable && vtable->query_submenu) {
     int count = 0;
+    // taken first, an invalidate() while the plugin runs wins
+    uint64_t generation = result_cache.generation();
+    auto start = std::chrono::steady_clock::now();
     LawnchResult *res =
         vtable->query_submenu(result_command.c_str(), term.c_str(), &count);
+    auto elapsed = std::chrono::steady_clock::now() - start;
     results.reserve(count);
     for (int i = 0; i < count; ++i) {
       SearchResult sr{res[i].name ? res[i].name : "",
@@ -136,6 +191,10 @@ Adapter::query_submenu(const std::string &result_command,
     if (vtable->free_results) {
       vtable->free_results(res, count);
     }
+    scratch.reset();
+    stats.record_query(elapsed, results.size());
+    if (is_cached())
+      result_cache.put(cache_key, results, generation);
   }
 #else
   (void)result_command;
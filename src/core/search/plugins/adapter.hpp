@@ -1,8 +1,13 @@
 #pragma once
 
 #include "../interface.hpp"
+#include "collection.hpp"
 #include "lawnch_plugin_api.h"
+#include "result_cache.hpp"
+#include "stats.hpp"
+#include "scratch_arena.hpp"
 
+#include <atomic>
 #include <string>
 #include <vector>
 
@@ -24,13 +29,28 @@ public:
   bool allow_history() const override;
   bool is_custom_sorted() const override;
 
+  Collection &get_collection() { return collection; }
+  ScratchArena &get_scratch() { return scratch; }
+  ResultCache &get_result_cache() { return result_cache; }
+  PluginStats &get_stats() { return stats; }
+
+  // one of LAWNCH_CACHE_POLICY_*, drops whatever was cached so far
+  void set_cache_policy(int policy);
+
 private:
+  bool is_cached() const;
+
   LawnchPluginVTable *vtable;
   uint32_t flags = 0;
+  std::atomic<int> cache_policy{0};
   mutable bool triggers_cached = false;
   mutable std::vector<std::string> cached_triggers;
   mutable bool help_cached = false;
   mutable SearchResult cached_help;
+  Collection collection;
+  ScratchArena scratch;
+  ResultCache result_cache;
+  PluginStats stats;
 };
 
 } // namespace Lawnch::Core::Search::Plugins
@@ -0,0 +1,142 @@
+#include "collection.hpp"
+#include "../../../helpers/string.hpp"
+#include <algorithm>
+
+namespace Lawnch::Core::Search::Plugins {
+
+void Collection::index_item(Item &item) {
+  item.name_lower = Lawnch::Str::to_lower_copy(item.result.name);
+  item.comment_lower = Lawnch::Str::to_lower_copy(item.result.comment);
+  item.keywords_lower = Lawnch::Str::to_lower_copy(item.keywords);
+}
+
+void Collection::set_items(std::vector<Item> new_items,
+                           const Weights &new_weights, size_t new_limit) {
+  std::lock_guard<std::mutex> lock(mutex);
+  items = std::move(new_items);
+  weights = new_weights;
+  limit = new_limit;
+  registered = true;
+  invalidate_narrowing();
+}
+
+void Collection::upsert_items(std::vector<Item> new_items) {
+  std::lock_guard<std::mutex> lock(mutex);
+  for (auto &item : new_items) {
+    auto it = std::find_if(items.begin(), items.end(), [&](const Item &e) {
+      return e.result.command == item.result.command;
+    });
+    if (it != items.end()) {
+      *it = std::move(item);
+    } else {
+      items.push_back(std::move(item));
+    }
+  }
+  registered = true;
+  invalidate_narrowing();
+}
+
+void Collection::remove_item(const std::string &command) {
+  std::lock_guard<std::mutex> lock(mutex);
+  items.erase(std::remove_if(items.begin(), items.end(),
+                             [&](const Item &e) {
+                               return e.result.command == command;
+                             }),
+              items.end());
+  invalidate_narrowing();
+}
+
+void Collection::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  items.clear();
+  registered = false;
+  invalidate_narrowing();
+}
+
+bool Collection::is_registered() const {
+  std::lock_guard<std::mutex> lock(mutex);
+  return registered;
+}
+
+void Collection::invalidate_narrowing() {
+  narrowing_valid = false;
+  last_term.clear();
+  last_matches.clear();
+}
+
+int Collection::score(const Item &item, const std::string &term_lower) const {
+  int best = Lawnch::Str::match_score_lowered(term_lower, item.name_lower) *
+             weights.name;
+  if (weights.comment > 0 && !item.comment_lower.empty()) {
+    best = std::max(best, Lawnch::Str::match_score_lowered(
+                              term_lower, item.comment_lower) *
+                              weights.comment);
+  }
+  if (weights.keywords > 0 && !item.keywords_lower.empty()) {
+    best = std::max(best, Lawnch::Str::match_score_lowered(
+                              term_lower, item.keywords_lower) *
+                              weights.keywords);
+  }
+  return best;
+}
+
+std::vector<SearchResult> Collection::query(const std::string &term,
+                                            bool truncate) {
+  std::lock_guard<std::mutex> lock(mutex);
+
+  std::string term_lower = Lawnch::Str::to_lower_copy(term);
+
+  // every matcher is substring based, so extending the term can only drop
+  // matches: scan the previous hits instead of the whole collection
+  bool narrow = narrowing_valid && !last_term.empty() &&
+                term_lower.size() > last_term.size() &&
+                term_lower.compare(0, last_term.size(), last_term) == 0;
+
+  std::vector<std::pair<int, size_t>> scored;
+  auto consider = [&](size_t idx) {
+    int s = score(items[idx], term_lower);
+    if (s > 0)
+      scored.emplace_back(s, idx);
+  };
+
+  if (narrow) {
+    scored.reserve(last_matches.size());
+    for (size_t idx : last_matches)
+      consider(idx);
+  } else {
+    scored.reserve(items.size());
+    for (size_t idx = 0; idx < items.size(); ++idx)
+      consider(idx);
+  }
+
+  last_term = term_lower;
+  last_matches.clear();
+  last_matches.reserve(scored.size());
+  for (const auto &[s, idx] : scored)
+    last_matches.push_back(idx);
+  narrowing_valid = true;
+
+  auto by_rank = [](const std::pair<int, size_t> &a,
+                    const std::pair<int, size_t> &b) {
+    if (a.first != b.first)
+      return a.first > b.first;
+    return a.second < b.second;
+  };
+
+  if (truncate && limit > 0 && scored.size() > limit) {
+    std::partial_sort(scored.begin(), scored.begin() + limit, scored.end(),
+                      by_rank);
+    scored.resize(limit);
+  } else {
+    std::sort(scored.begin(), scored.end(), by_rank);
+  }
+
+  std::vector<SearchResult> results;
+  results.reserve(scored.size());
+  for (const auto &[s, idx] : scored) {
+    results.push_back(items[idx].result);
+  }
+  return results;
+}
+
+} // namespace Lawnch::Core::Search::Plugins
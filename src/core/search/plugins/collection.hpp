@@ -0,0 +1,61 @@
+#pragma once
+
+#include "../interface.hpp"
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace Lawnch::Core::Search::Plugins {
+
+// Host-owned, pre-indexed item list a plugin registers once through the
+// collection host extension. Queries are filtered and ranked here instead of
+// crossing the plugin ABI once per item.
+class Collection {
+public:
+  struct Item {
+    SearchResult result;
+    std::string keywords;
+
+    std::string name_lower;
+    std::string comment_lower;
+    std::string keywords_lower;
+  };
+
+  struct Weights {
+    int name = 100;
+    int comment = 40;
+    int keywords = 70;
+  };
+
+  // `new_limit` is the most results a query returns when truncating, 0 for
+  // no limit
+  void set_items(std::vector<Item> new_items, const Weights &new_weights,
+                 size_t new_limit);
+  void upsert_items(std::vector<Item> new_items);
+  void remove_item(const std::string &command);
+  void clear();
+
+  bool is_registered() const;
+  // Matches ranked by score, with `truncate` only the best `limit` of them.
+  // Only truncate when nothing re-ranks the results afterwards.
+  std::vector<SearchResult> query(const std::string &term, bool truncate);
+
+  static void index_item(Item &item);
+
+private:
+  int score(const Item &item, const std::string &term_lower) const;
+  void invalidate_narrowing();
+
+  mutable std::mutex mutex;
+  bool registered = false;
+  std::vector<Item> items;
+  Weights weights;
+  size_t limit = 0;
+
+  // matches of the previous term, reused while the user keeps typing
+  std::string last_term;
+  std::vector<size_t> last_matches;
+  bool narrowing_valid = false;
+};
+
+} // namespace Lawnch::Core::Search::Plugins
@@ -0,0 +1,147 @@
+#pragma once
+
+/*
+ * Optional host extensions for lawnch plugins.
+ *
+ * These live next to the host rather than in lawnch_plugin_api.h so that
+ * plugins built against older API headers keep loading unchanged. A plugin
+ * opts in by exporting
+ *
+ *   void lawnch_plugin_set_host_ext(const LawnchHostExtApi *ext);
+ *
+ * which the host calls once, before vtable->init. The table stays valid for
+ * the lifetime of the plugin. Every call takes the LawnchHostApi pointer the
+ * plugin received in init so the host knows which plugin is calling.
+ */
+
+#include "lawnch_plugin_api.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define LAWNCH_HOST_EXT_VERSION 3
+#define LAWNCH_PLUGIN_HOST_EXT_SYMBOL "lawnch_plugin_set_host_ext"
+
+/*
+ * Result cache policy, declared with cache_api->set_policy (usually from
+ * init). With anything but NONE the host remembers the results per term
+ * (and per submenu command), so retyping a term does not call the plugin
+ * again. LawnchPluginVTable.flags is left to lawnch_plugin_api.h.
+ *
+ * PURE: results only depend on the term; kept for the whole session.
+ * TTL: entries expire after the TTL set with cache_api->set_ttl
+ *      (LAWNCH_CACHE_DEFAULT_TTL_MS otherwise).
+ * INVALIDATE_ON_EVENT: kept until the plugin calls cache_api->invalidate,
+ *      e.g. when it gets notified that its data source changed.
+ *
+ * cache_api->invalidate drops the cache under every policy.
+ */
+#define LAWNCH_CACHE_POLICY_NONE 0
+#define LAWNCH_CACHE_POLICY_PURE 1
+#define LAWNCH_CACHE_POLICY_TTL 2
+#define LAWNCH_CACHE_POLICY_INVALIDATE_ON_EVENT 3
+#define LAWNCH_CACHE_DEFAULT_TTL_MS 5000
+
+/* One searchable entry. All strings are copied by the host. */
+typedef struct LawnchCollectionItem {
+  const char *name;     /* displayed and searched */
+  const char *comment;  /* displayed and searched */
+  const char *keywords; /* searched only, may be NULL */
+  const char *icon;
+  const char *command;  /* also the key used by upsert/remove */
+  const char *type;
+  const char *preview_image_path; /* may be NULL */
+  int has_submenu;
+} LawnchCollectionItem;
+
+/* Relative weight (0-100) of a match in each field. */
+typedef struct LawnchCollectionWeights {
+  int name;
+  int comment;
+  int keywords;
+} LawnchCollectionWeights;
+
+/*
+ * Once a plugin registers a collection, the host answers queries for the
+ * plugin's triggers from it (filtering, ranking, top-K) and vtable->query is
+ * no longer called. clear() hands querying back to the plugin.
+ */
+typedef struct LawnchCollectionApi {
+  /* Replace the whole collection. weights may be NULL for defaults. */
+  void (*set_items)(const LawnchHostApi *host,
+                    const LawnchCollectionItem *items, int count,
+                    const LawnchCollectionWeights *weights);
+  /* Insert or replace items, matched by command. */
+  void (*upsert_items)(const LawnchHostApi *host,
+                       const LawnchCollectionItem *items, int count);
+  void (*remove_item)(const LawnchHostApi *host, const char *command);
+  void (*clear)(const LawnchHostApi *host);
+} LawnchCollectionApi;
+
+/*
+ * The *_into variants write into a caller-provided buffer instead of
+ * returning malloc'd memory. Like snprintf they always NUL-terminate when
+ * buf_size > 0 and return the full length of the result, so a return value
+ * >= buf_size means the output was truncated.
+ */
+typedef struct LawnchStrExtApi {
+  int (*trim_into)(const char *s, char *buf, int buf_size);
+  int (*to_lower_into)(const char *s, char *buf, int buf_size);
+  int (*unescape_into)(const char *s, char *buf, int buf_size);
+  int (*escape_into)(const char *s, char *buf, int buf_size);
+  int (*replace_all_into)(const char *s, const char *from, const char *to,
+                          char *buf, int buf_size);
+  /* Same as match_score for each item, lowering the query only once. */
+  void (*match_score_many)(const char *query, const char **items, int count,
+                           int *scores);
+  /* Same as tokenize, but the array and tokens live in the scratch arena. */
+  const char **(*tokenize_scratch)(const LawnchHostApi *host, const char *s,
+                                   char delim, int *count);
+} LawnchStrExtApi;
+
+typedef struct LawnchFsExtApi {
+  int (*get_home_path_into)(char *buf, int buf_size);
+  int (*expand_tilde_into)(const char *path, char *buf, int buf_size);
+  int (*get_config_home_into)(char *buf, int buf_size);
+  int (*get_data_home_into)(char *buf, int buf_size);
+  int (*get_cache_home_into)(char *buf, int buf_size);
+  /* Host-owned and resolved once; must not be freed. */
+  const char *const *(*get_data_dirs)(int *count);
+  const char *const *(*get_icon_dirs)(int *count);
+} LawnchFsExtApi;
+
+/*
+ * Per-plugin scratch memory for use inside query callbacks. It never needs
+ * freeing: the host resets it after query/query_submenu returns and the
+ * results have been copied, so results may point into it directly.
+ */
+typedef struct LawnchScratchApi {
+  void *(*alloc)(const LawnchHostApi *host, size_t size);
+  char *(*strdup)(const LawnchHostApi *host, const char *s);
+} LawnchScratchApi;
+
+/* Safe to call from any thread. */
+typedef struct LawnchCacheApi {
+  void (*invalidate)(const LawnchHostApi *host);
+  void (*set_ttl)(const LawnchHostApi *host, int ttl_ms);
+  /* Resets the TTL to the policy's default, so call set_ttl after it. */
+  void (*set_policy)(const LawnchHostApi *host, int policy);
+} LawnchCacheApi;
+
+typedef struct LawnchHostExtApi {
+  int ext_api_version;
+  const LawnchCollectionApi *collection_api;
+  /* ext_api_version >= 2 */
+  const LawnchStrExtApi *str_ext_api;
+  const LawnchFsExtApi *fs_ext_api;
+  const LawnchScratchApi *scratch_api;
+  /* ext_api_version >= 3 */
+  const LawnchCacheApi *cache_api;
+} LawnchHostExtApi;
+
+typedef void (*LawnchPluginSetHostExtFunc)(const LawnchHostExtApi *ext);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,7 +3,10 @@
 #include "../../../helpers/logger.hpp"
 #include "../../../helpers/string.hpp"
 #include "adapter.hpp"
+#include "lawnch_host_ext.h"
 #include <algorithm>
+#include <cctype>
+#include <chrono>
 #include <cstdlib>
 #include <cstring>
 #include <dlfcn.h>
@@ -22,9 +25,29 @@ struct PluginApiContext {
   std::string plugin_name;
   const Config::Config &config;
   Manager *manager;
+  Adapter *adapter;
   LawnchHostApi host_api;
 };
 
+// A plugin that has been opened and initialized but not yet registered with
+// the manager. Produced on a worker thread when preloading.
+struct LoadedPlugin {
+  std::string name;
+  std::string path;
+  void *handle = nullptr;
+  std::unique_ptr<Adapter> adapter;
+  std::unique_ptr<PluginApiContext> context;
+  std::vector<std::string> triggers;
+  SearchResult help;
+
+  ~LoadedPlugin() {
+    adapter.reset();
+    context.reset();
+    if (handle)
+      dlclose(handle);
+  }
+};
+
 // C callback wrappers
 static const char *s_get_config_value(const LawnchHostApi *host,
                                       const char *key) {
@@ -191,11 +214,277 @@ static const LawnchStrApi s_str_api = {.trim = s_str_trim,
                                        .free_str = s_free_str,
                                        .free_str_array = s_free_str_array};
 
+static Adapter *adapter_from_host(const LawnchHostApi *host) {
+  if (!host || !host->userdata) {
+    return nullptr;
+  }
+  return static_cast<PluginApiContext *>(host->userdata)->adapter;
+}
+
+static Collection::Item to_collection_item(const LawnchCollectionItem &it) {
+  Collection::Item item;
+  item.result = SearchResult{
+      it.name ? it.name : "",
+      it.comment ? it.comment : "",
+      it.icon ? it.icon : "",
+      it.command ? it.command : "",
+      it.type ? it.type : "",
+      it.preview_image_path ? it.preview_image_path : "",
+      0,
+  };
+  item.result.has_submenu = it.has_submenu != 0;
+  item.keywords = it.keywords ? it.keywords : "";
+  Collection::index_item(item);
+  return item;
+}
+
+static std::vector<Collection::Item>
+to_collection_items(const LawnchCollectionItem *items, int count) {
+  std::vector<Collection::Item> out;
+  if (!items || count <= 0)
+    return out;
+  out.reserve(count);
+  for (int i = 0; i < count; ++i) {
+    out.push_back(to_collection_item(items[i]));
+  }
+  return out;
+}
+
+static void s_collection_set_items(const LawnchHostApi *host,
+                                   const LawnchCollectionItem *items,
+                                   int count,
+                                   const LawnchCollectionWeights *weights) {
+  Adapter *adapter = adapter_from_host(host);
+  if (!adapter)
+    return;
+  Collection::Weights w;
+  if (weights) {
+    w.name = weights->name;
+    w.comment = weights->comment;
+    w.keywords = weights->keywords;
+  }
+  const auto &config = static_cast<PluginApiContext *>(host->userdata)->config;
+  adapter->get_collection().set_items(to_collection_items(items, count), w,
+                                      std::max(config.results_limit, 0));
+}
+
+static void s_collection_upsert_items(const LawnchHostApi *host,
+                                      const LawnchCollectionItem *items,
+                                      int count) {
+  if (Adapter *adapter = adapter_from_host(host)) {
+    adapter->get_collection().upsert_items(to_collection_items(items, count));
+  }
+}
+
+static void s_collection_remove_item(const LawnchHostApi *host,
+                                     const char *command) {
+  if (Adapter *adapter = adapter_from_host(host)) {
+    adapter->get_collection().remove_item(command ? command : "");
+  }
+}
+
+static void s_collection_clear(const LawnchHostApi *host) {
+  if (Adapter *adapter = adapter_from_host(host)) {
+    adapter->get_collection().clear();
+  }
+}
+
+static const LawnchCollectionApi s_collection_api = {
+    .set_items = s_collection_set_items,
+    .upsert_items = s_collection_upsert_items,
+    .remove_item = s_collection_remove_item,
+    .clear = s_collection_clear};
+
+static int copy_into(std::string_view s, char *buf, int buf_size) {
+  if (buf && buf_size > 0) {
+    size_t n = std::min(s.size(), static_cast<size_t>(buf_size - 1));
+    std::memcpy(buf, s.data(), n);
+    buf[n] = '\0';
+  }
+  return static_cast<int>(s.size());
+}
+
+static int s_str_trim_into(const char *s, char *buf, int buf_size) {
+  std::string_view sv = s ? s : "";
+  size_t begin = sv.find_first_not_of(" \t");
+  if (begin == std::string_view::npos)
+    return copy_into({}, buf, buf_size);
+  size_t end = sv.find_last_not_of(" \t");
+  return copy_into(sv.substr(begin, end - begin + 1), buf, buf_size);
+}
+static int s_str_to_lower_into(const char *s, char *buf, int buf_size) {
+  std::string_view sv = s ? s : "";
+  if (buf && buf_size > 0) {
+    size_t n = std::min(sv.size(), static_cast<size_t>(buf_size - 1));
+    for (size_t i = 0; i < n; ++i)
+      buf[i] = std::tolower(static_cast<unsigned char>(sv[i]));
+    buf[n] = '\0';
+  }
+  return static_cast<int>(sv.size());
+}
+static int s_str_unescape_into(const char *s, char *buf, int buf_size) {
+  return copy_into(Lawnch::Str::unescape(s ? s : ""), buf, buf_size);
+}
+static int s_str_escape_into(const char *s, char *buf, int buf_size) {
+  return copy_into(Lawnch::Str::escape(s ? s : ""), buf, buf_size);
+}
+static int s_str_replace_all_into(const char *s, const char *from,
+                                  const char *to, char *buf, int buf_size) {
+  return copy_into(
+      Lawnch::Str::replace_all(s ? s : "", from ? from : "", to ? to : ""),
+      buf, buf_size);
+}
+static void s_str_match_score_many(const char *query, const char **items,
+                                   int count, int *scores) {
+  if (!items || !scores || count <= 0)
+    return;
+  std::string query_lower = Lawnch::Str::to_lower_copy(query ? query : "");
+  std::string item_lower;
+  for (int i = 0; i < count; ++i) {
+    item_lower.assign(items[i] ? items[i] : "");
+    Lawnch::Str::to_lower(item_lower);
+    scores[i] = Lawnch::Str::match_score_lowered(query_lower, item_lower);
+  }
+}
+
+static ScratchArena *scratch_from_host(const LawnchHostApi *host) {
+  Adapter *adapter = adapter_from_host(host);
+  return adapter ? &adapter->get_scratch() : nullptr;
+}
+
+static const char **s_str_tokenize_scratch(const LawnchHostApi *host,
+                                           const char *s, char delim,
+                                           int *cnt) {
+  if (cnt)
+    *cnt = 0;
+  ScratchArena *scratch = scratch_from_host(host);
+  if (!scratch)
+    return nullptr;
+  auto tokens = Lawnch::Str::tokenize(s ? s : "", delim);
+  auto **arr = static_cast<const char **>(
+      scratch->alloc(sizeof(const char *) * (tokens.size() + 1)));
+  for (size_t i = 0; i < tokens.size(); ++i)
+    arr[i] = scratch->strdup(tokens[i]);
+  arr[tokens.size()] = nullptr;
+  if (cnt)
+    *cnt = tokens.size();
+  return arr;
+}
+
+static const LawnchStrExtApi s_str_ext_api = {
+    .trim_into = s_str_trim_into,
+    .to_lower_into = s_str_to_lower_into,
+    .unescape_into = s_str_unescape_into,
+    .escape_into = s_str_escape_into,
+    .replace_all_into = s_str_replace_all_into,
+    .match_score_many = s_str_match_score_many,
+    .tokenize_scratch = s_str_tokenize_scratch};
+
+// Owns the strings behind the host-owned directory lists
+struct DirList {
+  std::vector<std::string> dirs;
+  std::vector<const char *> ptrs;
+
+  explicit DirList(std::vector<std::string> list) : dirs(std::move(list)) {
+    for (const auto &d : dirs)
+      ptrs.push_back(d.c_str());
+    ptrs.push_back(nullptr);
+  }
+};
+
+static int s_fs_get_home_into(char *buf, int buf_size) {
+  return copy_into(Lawnch::Fs::get_home_path().string(), buf, buf_size);
+}
+static int s_fs_expand_tilde_into(const char *path, char *buf, int buf_size) {
+  return copy_into(Lawnch::Fs::expand_tilde(path ? path : "").string(), buf,
+                   buf_size);
+}
+static int s_fs_get_config_home_into(char *buf, int buf_size) {
+  return copy_into(Lawnch::Fs::get_config_home().string(), buf, buf_size);
+}
+static int s_fs_get_data_home_into(char *buf, int buf_size) {
+  return copy_into(Lawnch::Fs::get_data_home().string(), buf, buf_size);
+}
+static int s_fs_get_cache_home_into(char *buf, int buf_size) {
+  return copy_into(Lawnch::Fs::get_cache_home().string(), buf, buf_size);
+}
+static const char *const *s_fs_get_data_dirs_cached(int *cnt) {
+  static const DirList list(Lawnch::Fs::get_data_dirs());
+  if (cnt)
+    *cnt = list.dirs.size();
+  return list.ptrs.data();
+}
+static const char *const *s_fs_get_icon_dirs_cached(int *cnt) {
+  static const DirList list(Lawnch::Fs::get_icon_dirs());
+  if (cnt)
+    *cnt = list.dirs.size();
+  return list.ptrs.data();
+}
+
+static const LawnchFsExtApi s_fs_ext_api = {
+    .get_home_path_into = s_fs_get_home_into,
+    .expand_tilde_into = s_fs_expand_tilde_into,
+    .get_config_home_into = s_fs_get_config_home_into,
+    .get_data_home_into = s_fs_get_data_home_into,
+    .get_cache_home_into = s_fs_get_cache_home_into,
+    .get_data_dirs = s_fs_get_data_dirs_cached,
+    .get_icon_dirs = s_fs_get_icon_dirs_cached};
+
+static void *s_scratch_alloc(const LawnchHostApi *host, size_t size) {
+  ScratchArena *scratch = scratch_from_host(host);
+  return scratch ? scratch->alloc(size) : nullptr;
+}
+static char *s_scratch_strdup(const LawnchHostApi *host, const char *s) {
+  ScratchArena *scratch = scratch_from_host(host);
+  return scratch ? scratch->strdup(s ? s : "") : nullptr;
+}
+
+static const LawnchScratchApi s_scratch_api = {.alloc = s_scratch_alloc,
+                                               .strdup = s_scratch_strdup};
+
+static void s_cache_invalidate(const LawnchHostApi *host) {
+  if (Adapter *adapter = adapter_from_host(host)) {
+    adapter->get_result_cache().clear();
+  }
+}
+static void s_cache_set_ttl(const LawnchHostApi *host, int ttl_ms) {
+  if (Adapter *adapter = adapter_from_host(host)) {
+    adapter->get_result_cache().set_ttl(
+        std::chrono::milliseconds(std::max(ttl_ms, 0)));
+  }
+}
+
+static void s_cache_set_policy(const LawnchHostApi *host, int policy) {
+  if (Adapter *adapter = adapter_from_host(host)) {
+    adapter->set_cache_policy(policy);
+  }
+}
+
+static const LawnchCacheApi s_cache_api = {.invalidate = s_cache_invalidate,
+                                           .set_ttl = s_cache_set_ttl,
+                                           .set_policy = s_cache_set_policy};
+
+static const LawnchHostExtApi s_host_ext_api = {
+    .ext_api_version = LAWNCH_HOST_EXT_VERSION,
+    .collection_api = &s_collection_api,
+    .str_ext_api = &s_str_ext_api,
+    .fs_ext_api = &s_fs_ext_api,
+    .scratch_api = &s_scratch_api,
+    .cache_api = &s_cache_api};
+
 Manager::Manager(const Config::Config &config) : m_config(config) {
   find_plugin_dirs();
 }
 
 Manager::~Manager() {
+  for (auto &[name, pending] : m_preloads) {
+    if (pending.valid())
+      pending.wait();
+  }
+  m_preloads.clear();
+
+  save_stats();
+
   m_trigger_map.clear();
   m_plugins.clear();
   m_api_contexts.clear();
@@ -212,6 +501,7 @@ const std::vector<std::unique_ptr<SearchMode>> &Manager::get_plugins() const {
 }
 
 std::string Manager::get_plugin_data_dir(const std::string &plugin_name) const {
+  std::lock_guard<std::mutex> lock(m_data_dirs_mutex);
   auto it = m_plugin_data_dirs.find(plugin_name);
   if (it != m_plugin_data_dirs.end()) {
     return it->second;
@@ -508,6 +798,7 @@ void Manager::load_triggers_cache() {
 void Manager::ensure_plugin_for_trigger(const std::string &query) {
   if (!plugins_loaded)
     ensure_plugins_loaded();
+  collect_preloads();
 
   auto it = m_lazy_triggers.find(query);
   if (it != m_lazy_triggers.end()) {
@@ -542,12 +833,35 @@ SearchMode *Manager::find_plugin(const std::string &trigger) {
   return nullptr;
 }
 
-void Manager::load_plugin(const std::string &name) {
+bool Manager::is_plugin_loaded(const std::string &name) const {
   for (const auto &ctx : m_api_contexts) {
     if (ctx->plugin_name == name)
-      return;
+      return true;
+  }
+  return false;
+}
+
+void Manager::load_plugin(const std::string &name) {
+  if (is_plugin_loaded(name))
+    return;
+
+  // A preload may already be underway; waiting for it is never slower than
+  // starting over.
+  auto pending = m_preloads.find(name);
+  if (pending != m_preloads.end()) {
+    auto loaded = pending->second.get();
+    m_preloads.erase(pending);
+    if (loaded) {
+      register_plugin(std::move(loaded));
+    }
+    return;
   }
 
+  register_plugin(open_plugin(name));
+}
+
+std::unique_ptr<LoadedPlugin>
+Manager::open_plugin(const std::string &name) {
   if (m_plugin_dirs.empty()) {
     Lawnch::Logger::log("PluginManager", Lawnch::Logger::LogLevel::WARNING,
                         "Attempting to load plugin '" + name +
@@ -562,6 +876,7 @@ void Manager::load_plugin(const std::string &name) {
   void *handle = nullptr;
   std::string found_path;
 
+  auto dlopen_start = std::chrono::steady_clock::now();
   for (const auto &dir : m_plugin_dirs) {
     std::string path = (fs::path(dir) / name / (name + ".so")).string();
     if (fs::exists(path)) {
@@ -583,7 +898,7 @@ void Manager::load_plugin(const std::string &name) {
     err_ss << "Cannot find or load plugin " << name << ".so";
     Lawnch::Logger::log("PluginManager", Lawnch::Logger::LogLevel::ERROR,
                         err_ss.str());
-    return;
+    return nullptr;
   }
 
   using entry_func = LawnchPluginVTable *(*)();
@@ -595,7 +910,7 @@ void Manager::load_plugin(const std::string &name) {
     Lawnch::Logger::log("PluginManager", Lawnch::Logger::LogLevel::ERROR,
                         err_ss.str());
     dlclose(handle);
-    return;
+    return nullptr;
   }
 
   LawnchPluginVTable *vtable = entry();
@@ -605,17 +920,22 @@ void Manager::load_plugin(const std::string &name) {
     Lawnch::Logger::log("PluginManager", Lawnch::Logger::LogLevel::ERROR,
                         err_ss.str());
     dlclose(handle);
-    return;
+    return nullptr;
   }
 
-  auto adapter = std::make_unique<Adapter>(vtable);
+  auto dlopen_time = std::chrono::steady_clock::now() - dlopen_start;
 
-  auto context = std::make_unique<PluginApiContext>(
-      PluginApiContext{name, m_config, this, {}});
+  auto loaded = std::make_unique<LoadedPlugin>();
+  loaded->name = name;
+  loaded->path = found_path;
+  loaded->handle = handle;
+  loaded->adapter = std::make_unique<Adapter>(vtable);
+  loaded->context = std::make_unique<PluginApiContext>(
+      PluginApiContext{name, m_config, this, loaded->adapter.get(), {}});
 
-  context->host_api = {
+  loaded->context->host_api = {
       .host_api_version = LAWNCH_PLUGIN_API_VERSION,
-      .userdata = context.get(),
+      .userdata = loaded->context.get(),
       .get_config_value = &s_get_config_value,
       .get_data_dir = &s_get_data_dir,
       .log_api = &s_log_api,
@@ -623,26 +943,123 @@ void Manager::load_plugin(const std::string &name) {
       .str_api = &s_str_api,
   };
 
-  adapter->init_with_api(&context->host_api);
-  auto triggers = adapter->get_triggers();
-  m_loaded_triggers[name] = triggers;
-  m_loaded_help[name] = adapter->get_help();
-  m_plugin_triggers[adapter.get()] = triggers;
+  auto set_host_ext = (LawnchPluginSetHostExtFunc)dlsym(
+      handle, LAWNCH_PLUGIN_HOST_EXT_SYMBOL);
+  if (set_host_ext) {
+    set_host_ext(&s_host_ext_api);
+  }
+
+  auto init_start = std::chrono::steady_clock::now();
+  loaded->adapter->init_with_api(&loaded->context->host_api);
+  loaded->adapter->get_stats().record_load(
+      dlopen_time, std::chrono::steady_clock::now() - init_start);
+  loaded->triggers = loaded->adapter->get_triggers();
+  loaded->help = loaded->adapter->get_help();
+  return loaded;
+}
+
+void Manager::register_plugin(std::unique_ptr<LoadedPlugin> loaded) {
+  if (!loaded || is_plugin_loaded(loaded->name))
+    return;
+
+  const std::string &name = loaded->name;
+  Adapter *adapter = loaded->adapter.get();
+
+  m_loaded_triggers[name] = loaded->triggers;
+  m_loaded_help[name] = loaded->help;
+  m_plugin_triggers[adapter] = loaded->triggers;
 
-  for (const auto &trigger : triggers) {
-    m_trigger_map[trigger] = adapter.get();
+  for (const auto &trigger : loaded->triggers) {
+    m_trigger_map[trigger] = adapter;
   }
 
-  m_handles.push_back(handle);
-  m_api_contexts.push_back(std::move(context));
-  m_plugins.push_back(std::move(adapter));
+  m_handles.push_back(loaded->handle);
+  loaded->handle = nullptr;
+  m_api_contexts.push_back(std::move(loaded->context));
+  m_plugins.push_back(std::move(loaded->adapter));
 
   std::stringstream info_ss;
-  info_ss << "Loaded plugin: " << name << " from " << found_path;
+  info_ss << "Loaded plugin: " << name << " from " << loaded->path;
   Lawnch::Logger::log("PluginManager", Lawnch::Logger::LogLevel::INFO,
                       info_ss.str());
 }
 
+void Manager::save_stats() const {
+  if (m_api_contexts.empty())
+    return;
+
+  auto stats = PluginStats::load_file();
+  for (const auto &context : m_api_contexts) {
+    stats[context->plugin_name].merge(context->adapter->get_stats());
+  }
+  PluginStats::save_file(stats);
+}
+
+void Manager::start_preload(const std::string &name) {
+  if (is_plugin_loaded(name) || m_preloads.count(name))
+    return;
+
+  Lawnch::Logger::log("PluginManager", Lawnch::Logger::LogLevel::DEBUG,
+                      "Preloading plugin '" + name + "' in background");
+  m_preloads.emplace(name, std::async(std::launch::async, [this, name]() {
+                       return open_plugin(name);
+                     }));
+}
+
+void Manager::collect_preloads() {
+  for (auto it = m_preloads.begin(); it != m_preloads.end();) {
+    if (it->second.wait_for(std::chrono::seconds(0)) !=
+        std::future_status::ready) {
+      ++it;
+      continue;
+    }
+    auto loaded = it->second.get();
+    it = m_preloads.erase(it);
+    register_plugin(std::move(loaded));
+  }
+}
+
+void Manager::preload_for_prefix(const std::string &text) {
+  collect_preloads();
+
+  // only a bare, partially typed trigger such as ":em" is a preload hint
+  if (text.size() < 2 || text[0] != ':' ||
+      text.find(' ') != std::string::npos) {
+    return;
+  }
+
+  ensure_plugins_loaded();
+
+  std::string candidate;
+  for (auto it = m_lazy_triggers.lower_bound(text);
+       it != m_lazy_triggers.end() &&
+       it->first.compare(0, text.size(), text) == 0;
+       ++it) {
+    if (candidate.empty()) {
+      candidate = it->second;
+    } else if (candidate != it->second) {
+      return; // prefix is still ambiguous
+    }
+  }
+
+  if (!candidate.empty()) {
+    start_preload(candidate);
+  }
+}
+
+void Manager::preload_warm_plugins() {
+  ensure_plugins_loaded();
+
+  for (const auto &name : m_config.preload_plugins) {
+    if (std::find(m_config.enabled_plugins.begin(),
+                  m_config.enabled_plugins.end(),
+                  name) == m_config.enabled_plugins.end()) {
+      continue;
+    }
+    start_preload(name);
+  }
+}
+
 const std::vector<SearchResult> &Manager::get_all_help() const {
   if (m_cached_help.empty() && plugins_loaded) {
     auto &mutable_this = const_cast<Manager &>(*this);
@@ -672,6 +1089,7 @@ Manager::get_triggers_for(const SearchMode *plugin) const {
 SearchMode *Manager::find_plugin_for_query(const std::string &term,
                                            std::string &out_query) {
   ensure_plugins_loaded();
+  collect_preloads();
 
   for (const auto &[trigger, plugin_name] : m_lazy_triggers) {
     if (term == trigger) {
@@ -2,8 +2,10 @@
 
 #include "../../config/config.hpp"
 #include "../interface.hpp"
+#include <future>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <vector>
 
@@ -11,6 +13,7 @@ namespace Lawnch::Core::Search::Plugins {
 
 class PluginAdapter;
 struct PluginApiContext;
+struct LoadedPlugin;
 
 class Manager {
 public:
@@ -29,6 +32,12 @@ private:
   void load_plugins();
   void ensure_plugins_loaded();
   void load_plugin(const std::string &name);
+  std::unique_ptr<LoadedPlugin> open_plugin(const std::string &name);
+  void register_plugin(std::unique_ptr<LoadedPlugin> loaded);
+  bool is_plugin_loaded(const std::string &name) const;
+  void start_preload(const std::string &name);
+  void collect_preloads();
+  void save_stats() const;
   void find_plugin_dirs();
   std::string find_plugin_data_dir(const std::string &plugin_name) const;
 
@@ -36,6 +45,7 @@ private:
   const Config::Config &m_config;
   std::vector<std::string> m_plugin_dirs;
   mutable std::map<std::string, std::string> m_plugin_data_dirs;
+  mutable std::mutex m_data_dirs_mutex;
   std::vector<void *> m_handles;
 
   std::vector<std::unique_ptr<SearchMode>> m_plugins;
@@ -45,6 +55,10 @@ private:
   std::map<std::string, SearchResult> m_loaded_help;
   std::map<const SearchMode *, std::vector<std::string>> m_plugin_triggers;
 
+  // plugins being loaded in the background, keyed by plugin name
+  std::map<std::string, std::future<std::unique_ptr<LoadedPlugin>>>
+      m_preloads;
+
   std::map<std::string, std::string> m_lazy_triggers;
   std::vector<SearchResult> m_cached_help;
   void load_triggers_cache();
@@ -53,6 +67,8 @@ private:
 
 public:
   void ensure_plugin_for_trigger(const std::string &query);
+  void preload_for_prefix(const std::string &text);
+  void preload_warm_plugins();
   const std::vector<SearchResult> &get_all_help() const;
   const std::vector<std::string> &
   get_triggers_for(const SearchMode *plugin) const;
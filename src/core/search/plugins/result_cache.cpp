@@ -0,0 +1,85 @@
+#include "result_cache.hpp"
+
+namespace Lawnch::Core::Search::Plugins {
+
+ResultCache::ResultCache(size_t max_bytes) : max_bytes(max_bytes) {}
+
+size_t ResultCache::estimate_bytes(const std::string &key,
+                                   const std::vector<SearchResult> &results) {
+  size_t bytes = sizeof(Entry) + key.size();
+  for (const auto &r : results) {
+    bytes += sizeof(SearchResult) + r.name.size() + r.comment.size() +
+             r.icon.size() + r.command.size() + r.type.size() +
+             r.preview_image_path.size();
+  }
+  return bytes;
+}
+
+std::optional<std::vector<SearchResult>>
+ResultCache::get(const std::string &key) {
+  std::lock_guard<std::mutex> lock(mutex);
+  auto it = index.find(key);
+  if (it == index.end())
+    return std::nullopt;
+
+  auto entry = it->second;
+  if (ttl.count() > 0 && Clock::now() - entry->stored > ttl) {
+    used_bytes -= entry->bytes;
+    lru.erase(entry);
+    index.erase(it);
+    return std::nullopt;
+  }
+
+  lru.splice(lru.begin(), lru, entry);
+  return entry->results;
+}
+
+uint64_t ResultCache::generation() {
+  std::lock_guard<std::mutex> lock(mutex);
+  return current_generation;
+}
+
+void ResultCache::put(const std::string &key,
+                      const std::vector<SearchResult> &results,
+                      uint64_t generation) {
+  size_t bytes = estimate_bytes(key, results);
+  std::lock_guard<std::mutex> lock(mutex);
+  if (bytes > max_bytes || generation != current_generation)
+    return;
+
+  auto it = index.find(key);
+  if (it != index.end()) {
+    used_bytes -= it->second->bytes;
+    lru.erase(it->second);
+    index.erase(it);
+  }
+
+  lru.push_front({key, results, bytes, Clock::now()});
+  index[key] = lru.begin();
+  used_bytes += bytes;
+  evict_to_fit();
+}
+
+void ResultCache::evict_to_fit() {
+  while (used_bytes > max_bytes && !lru.empty()) {
+    auto &last = lru.back();
+    used_bytes -= last.bytes;
+    index.erase(last.key);
+    lru.pop_back();
+  }
+}
+
+void ResultCache::clear() {
+  std::lock_guard<std::mutex> lock(mutex);
+  lru.clear();
+  index.clear();
+  used_bytes = 0;
+  ++current_generation;
+}
+
+void ResultCache::set_ttl(std::chrono::milliseconds new_ttl) {
+  std::lock_guard<std::mutex> lock(mutex);
+  ttl = new_ttl;
+}
+
+} // namespace Lawnch::Core::Search::Plugins
@@ -0,0 +1,56 @@
+#pragma once
+
+#include "../interface.hpp"
+#include <chrono>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Lawnch::Core::Search::Plugins {
+
+// LRU of query key -> results for plugins that declare a cache policy.
+// Bounded by an approximate byte budget rather than an entry count since
+// result lists vary wildly in size between plugins.
+class ResultCache {
+public:
+  using Clock = std::chrono::steady_clock;
+
+  explicit ResultCache(size_t max_bytes = 2 * 1024 * 1024);
+
+  std::optional<std::vector<SearchResult>> get(const std::string &key);
+  // Taken before asking the plugin and handed back to put(), so results
+  // computed across a clear() are dropped instead of cached.
+  uint64_t generation();
+  void put(const std::string &key, const std::vector<SearchResult> &results,
+           uint64_t generation);
+  void clear();
+
+  // 0 disables expiry
+  void set_ttl(std::chrono::milliseconds ttl);
+
+private:
+  struct Entry {
+    std::string key;
+    std::vector<SearchResult> results;
+    size_t bytes = 0;
+    Clock::time_point stored;
+  };
+
+  static size_t estimate_bytes(const std::string &key,
+                               const std::vector<SearchResult> &results);
+  void evict_to_fit();
+
+  std::mutex mutex;
+  std::list<Entry> lru; // most recently used first
+  std::unordered_map<std::string, std::list<Entry>::iterator> index;
+  size_t max_bytes;
+  size_t used_bytes = 0;
+  uint64_t current_generation = 0;
+  std::chrono::milliseconds ttl{0};
+};
+
+} // namespace Lawnch::Core::Search::Plugins
@@ -0,0 +1,55 @@
+#include "scratch_arena.hpp"
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+
+namespace Lawnch::Core::Search::Plugins {
+
+ScratchArena::ScratchArena(size_t block_size) : block_size(block_size) {}
+
+void ScratchArena::add_block(size_t min_size) {
+  size_t size = std::max(block_size, min_size);
+  blocks.push_back({std::make_unique<std::byte[]>(size), size});
+  used = 0;
+}
+
+void *ScratchArena::alloc(size_t size, size_t align) {
+  if (size == 0)
+    size = 1;
+
+  if (!blocks.empty()) {
+    auto &block = blocks.back();
+    uintptr_t base = reinterpret_cast<uintptr_t>(block.data.get());
+    uintptr_t aligned = (base + used + align - 1) & ~(uintptr_t)(align - 1);
+    size_t offset = aligned - base;
+    if (offset + size <= block.size) {
+      used = offset + size;
+      return block.data.get() + offset;
+    }
+  }
+
+  add_block(size + align);
+  return alloc(size, align);
+}
+
+char *ScratchArena::strdup(std::string_view s) {
+  char *out = static_cast<char *>(alloc(s.size() + 1, 1));
+  std::memcpy(out, s.data(), s.size());
+  out[s.size()] = '\0';
+  return out;
+}
+
+void ScratchArena::reset() {
+  if (blocks.size() > 1) {
+    // the last query did not fit in one block, so grow it for the next one
+    size_t total = 0;
+    for (const auto &b : blocks)
+      total += b.size;
+    blocks.clear();
+    add_block(total);
+    return;
+  }
+  used = 0;
+}
+
+} // namespace Lawnch::Core::Search::Plugins
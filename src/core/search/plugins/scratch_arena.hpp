@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <vector>
+
+namespace Lawnch::Core::Search::Plugins {
+
+// Bump allocator handed to plugins through the scratch host extension.
+// Everything allocated from it is released at once when the host resets it
+// after a query returns.
+class ScratchArena {
+public:
+  explicit ScratchArena(size_t block_size = 16 * 1024);
+
+  void *alloc(size_t size, size_t align = alignof(std::max_align_t));
+  char *strdup(std::string_view s);
+  void reset();
+
+private:
+  struct Block {
+    std::unique_ptr<std::byte[]> data;
+    size_t size = 0;
+  };
+
+  void add_block(size_t min_size);
+
+  size_t block_size;
+  std::vector<Block> blocks;
+  size_t used = 0; // bytes used in blocks.back()
+};
+
+} // namespace Lawnch::Core::Search::Plugins
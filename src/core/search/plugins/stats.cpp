@@ -0,0 +1,137 @@
+#include "stats.hpp"
+#include "../../../helpers/fs.hpp"
+#include "../../../helpers/logger.hpp"
+#include <fstream>
+#include <sstream>
+
+namespace fs = std::filesystem;
+
+namespace Lawnch::Core::Search::Plugins {
+
+namespace {
+constexpr const char *STATS_HEADER = "LAWNCH_PLUGIN_STATS 3";
+// version 2 also had an init heap delta after init_ms, version 1 that and a
+// per query heap delta after the result count
+constexpr const char *STATS_HEADER_V2 = "LAWNCH_PLUGIN_STATS 2";
+constexpr const char *STATS_HEADER_V1 = "LAWNCH_PLUGIN_STATS 1";
+constexpr double FIRST_BUCKET_US = 16.0;
+
+double to_ms(std::chrono::nanoseconds ns) {
+  return std::chrono::duration<double, std::milli>(ns).count();
+}
+} // namespace
+
+void PluginStats::record_load(std::chrono::nanoseconds dlopen_time,
+                              std::chrono::nanoseconds init_time) {
+  loads++;
+  dlopen_ms += to_ms(dlopen_time);
+  init_ms += to_ms(init_time);
+}
+
+void PluginStats::record_query(std::chrono::nanoseconds time,
+                               size_t result_count) {
+  double us = std::chrono::duration<double, std::micro>(time).count();
+  size_t bucket = 0;
+  double bound = FIRST_BUCKET_US;
+  while (us >= bound && bucket + 1 < LATENCY_BUCKETS) {
+    bound *= 2;
+    bucket++;
+  }
+  latency[bucket]++;
+  queries++;
+  results += result_count;
+}
+
+double PluginStats::latency_percentile_ms(double percentile) const {
+  if (queries == 0)
+    return 0;
+  uint64_t target = (uint64_t)(percentile / 100.0 * queries + 0.5);
+  if (target == 0)
+    target = 1;
+
+  uint64_t seen = 0;
+  double bound = FIRST_BUCKET_US;
+  for (size_t i = 0; i < LATENCY_BUCKETS; ++i, bound *= 2) {
+    seen += latency[i];
+    if (seen >= target)
+      return bound / 1000.0;
+  }
+  return bound / 1000.0;
+}
+
+void PluginStats::merge(const PluginStats &other) {
+  loads += other.loads;
+  dlopen_ms += other.dlopen_ms;
+  init_ms += other.init_ms;
+  queries += other.queries;
+  results += other.results;
+  for (size_t i = 0; i < LATENCY_BUCKETS; ++i)
+    latency[i] += other.latency[i];
+}
+
+fs::path PluginStats::file_path() {
+  return Lawnch::Fs::get_cache_home() / "lawnch" / "plugin-stats";
+}
+
+std::map<std::string, PluginStats> PluginStats::load_file() {
+  std::map<std::string, PluginStats> stats;
+  std::ifstream file(file_path());
+  if (!file.is_open())
+    return stats;
+
+  std::string line;
+  if (!std::getline(file, line) ||
+      (line != STATS_HEADER && line != STATS_HEADER_V2 &&
+       line != STATS_HEADER_V1))
+    return stats;
+  bool v1 = line == STATS_HEADER_V1;
+  bool has_init_heap = v1 || line == STATS_HEADER_V2;
+
+  // name loads dlopen_ms init_ms queries results followed by the latency
+  // buckets
+  while (std::getline(file, line)) {
+    std::istringstream ss(line);
+    std::string name;
+    PluginStats s;
+    ss >> name >> s.loads >> s.dlopen_ms >> s.init_ms;
+    if (has_init_heap) {
+      int64_t init_heap_delta;
+      ss >> init_heap_delta;
+    }
+    ss >> s.queries >> s.results;
+    if (v1) {
+      int64_t query_heap_delta;
+      ss >> query_heap_delta;
+    }
+    for (auto &bucket : s.latency)
+      ss >> bucket;
+    if (!ss.fail() && !name.empty())
+      stats[name] = s;
+  }
+  return stats;
+}
+
+void PluginStats::save_file(const std::map<std::string, PluginStats> &stats) {
+  fs::path path = file_path();
+  std::error_code ec;
+  fs::create_directories(path.parent_path(), ec);
+
+  std::ostringstream out;
+  out << STATS_HEADER << "\n";
+  for (const auto &[name, s] : stats) {
+    out << name << " " << s.loads << " " << s.dlopen_ms << " " << s.init_ms
+        << " " << s.queries << " " << s.results;
+    for (auto bucket : s.latency)
+      out << " " << bucket;
+    out << "\n";
+  }
+
+  // two instances exiting at once or a crash halfway never leave a
+  // truncated file behind
+  if (!Lawnch::Fs::write_file_atomic(path, out.str())) {
+    Lawnch::Logger::log("PluginManager", Lawnch::Logger::LogLevel::ERROR,
+                        "Failed to write plugin stats file.");
+  }
+}
+
+} // namespace Lawnch::Core::Search::Plugins
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+
+namespace Lawnch::Core::Search::Plugins {
+
+// Load and query cost of one plugin, accumulated across sessions in
+// $XDG_CACHE_HOME/lawnch/plugin-stats and shown by `lawnch pm stats`.
+struct PluginStats {
+  // latency bucket i holds queries that took less than 16us * 2^i
+  static constexpr size_t LATENCY_BUCKETS = 24;
+
+  uint64_t loads = 0;
+  double dlopen_ms = 0; // totals, divide by loads
+  double init_ms = 0;
+
+  uint64_t queries = 0;
+  uint64_t results = 0;
+  std::array<uint64_t, LATENCY_BUCKETS> latency{};
+
+  void record_load(std::chrono::nanoseconds dlopen_time,
+                   std::chrono::nanoseconds init_time);
+  void record_query(std::chrono::nanoseconds time, size_t result_count);
+  // upper bound of the bucket holding the given percentile (0-100)
+  double latency_percentile_ms(double percentile) const;
+  void merge(const PluginStats &other);
+
+  static std::filesystem::path file_path();
+  static std::map<std::string, PluginStats> load_file();
+  static void save_file(const std::map<std::string, PluginStats> &stats);
+};
+
+} // namespace Lawnch::Core::Search::Plugins
@@ -1,97 +1,71 @@
 #include "buffer.hpp"
 #include "../../../helpers/logger.hpp"
-#include <cstring>
-#include <fcntl.h>
-#include <iostream>
-#include <sys/mman.h>
-#include <sys/types.h>
-#include <unistd.h>
+#include "damage.hpp"
 
 namespace Lawnch::Core::Window::Render {
 
+static const struct wl_buffer_listener buffer_listener = {
+    .release = Buffer::release_handler,
+};
+
 Buffer::Buffer() {}
 
 Buffer::~Buffer() { destroy(); }
 
-static int create_shm_file(off_t size) {
-  int fd = memfd_create("lawnch-buffer", MFD_CLOEXEC);
-  if (fd < 0)
-    return -1;
-
-  int ret = ftruncate(fd, size);
-  if (ret < 0) {
-    close(fd);
-    return -1;
-  }
-  return fd;
-}
-
-void Buffer::create(struct wl_shm *shm, int w, int h) {
+bool Buffer::create(struct wl_shm_pool *pool, uint8_t *pool_data, int off,
+                    int w, int h, uint32_t threads) {
   destroy(); // Setup fresh
 
   if (w <= 0 || h <= 0) {
     Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
                         "Invalid buffer dimensions");
-    return;
+    return false;
   }
 
   width = w;
   height = h;
+  offset = off;
+  thread_count = threads;
   int stride = width * 4; // ARGB32
-  shm_size = stride * height;
-
-  int fd = create_shm_file(shm_size);
-  if (fd < 0) {
-    Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
-                        "Failed to create SHM file");
-    return;
-  }
-
-  shm_data = mmap(NULL, shm_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
-  if (shm_data == MAP_FAILED) {
-    close(fd);
-    Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
-                        "Failed to mmap");
-    shm_data = nullptr;
-    return;
-  }
-
-  struct wl_shm_pool *pool = wl_shm_create_pool(shm, fd, shm_size);
-  if (!pool) {
-    close(fd);
-    munmap(shm_data, shm_size);
-    shm_data = nullptr;
-    Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
-                        "Failed to create SHM pool");
-    return;
-  }
 
-  wl_buffer = wl_shm_pool_create_buffer(pool, 0, width, height, stride,
+  wl_buffer = wl_shm_pool_create_buffer(pool, offset, width, height, stride,
                                         WL_SHM_FORMAT_ARGB8888);
-  wl_shm_pool_destroy(pool);
-  close(fd);
-
   if (!wl_buffer) {
-    munmap(shm_data, shm_size);
-    shm_data = nullptr;
     Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
                         "Failed to create wl_buffer");
-    return;
+    return false;
+  }
+  wl_buffer_add_listener(wl_buffer, &buffer_listener, this);
+
+  if (!rebind(pool_data)) {
+    destroy();
+    return false;
   }
+  return true;
+}
+
+bool Buffer::rebind(uint8_t *pool_data) {
+  context.end();
+  image.reset();
 
-  BLResult result = image.create_from_data(width, height, BL_FORMAT_PRGB32, shm_data, stride);
+  int stride = width * 4;
+  BLResult result = image.create_from_data(
+      width, height, BL_FORMAT_PRGB32, pool_data + offset, stride);
   if (result != BL_SUCCESS) {
     Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
                         "Failed to create Blend2D image");
-    return;
+    return false;
   }
 
-  result = context.begin(image);
+  BLContextCreateInfo create_info{};
+  create_info.thread_count = thread_count;
+  result = context.begin(image, create_info);
   if (result != BL_SUCCESS) {
     Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
                         "Failed to begin Blend2D context");
-    return;
+    return false;
   }
+  return true;
 }
 
 void Buffer::destroy() {
@@ -102,11 +76,35 @@ void Buffer::destroy() {
 
   context.end();
   image.reset();
+  busy = false;
+  full_damage = true;
+  pending_damage.clear();
+}
+
+void Buffer::add_damage(const std::vector<BLRectI> &damage) {
+  if (full_damage)
+    return;
+  pending_damage.insert(pending_damage.end(), damage.begin(), damage.end());
+  Damage::merge(pending_damage);
+}
 
-  if (shm_data) {
-    munmap(shm_data, shm_size);
-    shm_data = nullptr;
+std::vector<BLRectI> Buffer::take_damage() {
+  std::vector<BLRectI> damage;
+  if (full_damage) {
+    damage.push_back(BLRectI(0, 0, width, height));
+  } else {
+    damage.swap(pending_damage);
   }
+  full_damage = false;
+  pending_damage.clear();
+  return damage;
+}
+
+void Buffer::release_handler(void *data, struct wl_buffer *) {
+  auto self = static_cast<Buffer *>(data);
+  self->busy = false;
+  if (self->on_release)
+    self->on_release(self);
 }
 
 } // namespace Lawnch::Core::Window::Render
@@ -1,17 +1,30 @@
 #pragma once
 
 #include <blend2d.h>
+#include <cstdint>
+#include <functional>
+#include <vector>
 #include <wayland-client.h>
 
 namespace Lawnch::Core::Window::Render {
 
+// One wl_buffer carved out of a BufferPool's shared memory. It is busy from
+// the moment it is handed out until the compositor releases it.
 class Buffer {
 public:
   Buffer();
   ~Buffer();
 
-  void create(struct wl_shm *shm, int width, int height);
+  Buffer(const Buffer &) = delete;
+  Buffer &operator=(const Buffer &) = delete;
+
+  // thread_count > 0 renders asynchronously on that many blend2d workers,
+  // flush(BL_CONTEXT_FLUSH_SYNC) before handing the buffer to the compositor
+  bool create(struct wl_shm_pool *pool, uint8_t *pool_data, int offset,
+              int width, int height, uint32_t thread_count = 0);
   void destroy();
+  // the pool was remapped after growing, point the image at the new mapping
+  bool rebind(uint8_t *pool_data);
 
   struct wl_buffer *get_wl_buffer() const { return wl_buffer; }
   BLContext &get_context() { return context; }
@@ -20,15 +33,29 @@ public:
   int get_height() const { return height; }
 
   bool is_valid() const { return wl_buffer != nullptr; }
+  bool is_busy() const { return busy; }
+  void mark_busy() { busy = true; }
+
+  // Damage of frames drawn since this buffer was last painted; a new buffer
+  // has undefined contents and needs a full repaint.
+  void add_damage(const std::vector<BLRectI> &damage);
+  std::vector<BLRectI> take_damage();
+
+  std::function<void(Buffer *)> on_release;
+
+  static void release_handler(void *data, struct wl_buffer *wl_buffer);
 
 private:
   struct wl_buffer *wl_buffer = nullptr;
   BLImage image;
   BLContext context;
-  void *shm_data = nullptr;
-  size_t shm_size = 0;
+  int offset = 0;
   int width = 0;
   int height = 0;
+  uint32_t thread_count = 0;
+  bool busy = false;
+  bool full_damage = true;
+  std::vector<BLRectI> pending_damage;
 };
 
 } // namespace Lawnch::Core::Window::Render
@@ -0,0 +1,194 @@
+#include "buffer_pool.hpp"
+#include "../../../helpers/logger.hpp"
+#include <algorithm>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+namespace Lawnch::Core::Window::Render {
+
+BufferPool::BufferPool() {}
+
+BufferPool::~BufferPool() { destroy(); }
+
+void BufferPool::destroy() {
+  buffers.clear();
+  previous = nullptr;
+  reap_retired(true);
+
+  free_memory(pool, fd, data, capacity);
+  capacity = 0;
+  width = 0;
+  height = 0;
+}
+
+void BufferPool::free_memory(struct wl_shm_pool *&pool, int &fd,
+                             uint8_t *&data, size_t capacity) {
+  if (pool) {
+    wl_shm_pool_destroy(pool);
+    pool = nullptr;
+  }
+  if (data) {
+    munmap(data, capacity);
+    data = nullptr;
+  }
+  if (fd >= 0) {
+    close(fd);
+    fd = -1;
+  }
+}
+
+void BufferPool::retire() {
+  Retired old;
+  for (auto &buffer : buffers) {
+    if (buffer->is_busy())
+      old.buffers.push_back(std::move(buffer));
+  }
+  buffers.clear();
+  // nothing held, the memory can be reused right away
+  if (old.buffers.empty())
+    return;
+
+  Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::DEBUG,
+                      "Resized while the compositor holds buffers, "
+                      "starting a new SHM file");
+  old.pool = pool;
+  old.fd = fd;
+  old.data = data;
+  old.capacity = capacity;
+  pool = nullptr;
+  fd = -1;
+  data = nullptr;
+  capacity = 0;
+  retired.push_back(std::move(old));
+}
+
+void BufferPool::reap_retired(bool all) {
+  for (auto it = retired.begin(); it != retired.end();) {
+    bool busy = std::any_of(it->buffers.begin(), it->buffers.end(),
+                            [](const auto &b) { return b->is_busy(); });
+    if (busy && !all) {
+      ++it;
+      continue;
+    }
+    it->buffers.clear();
+    free_memory(it->pool, it->fd, it->data, it->capacity);
+    it = retired.erase(it);
+  }
+}
+
+bool BufferPool::ensure_capacity(size_t size) {
+  if (size <= capacity)
+    return true;
+
+  if (fd < 0) {
+    fd = memfd_create("lawnch-buffer", MFD_CLOEXEC);
+    if (fd < 0) {
+      Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
+                          "Failed to create SHM file");
+      return false;
+    }
+  }
+
+  if (ftruncate(fd, size) < 0) {
+    Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
+                        "Failed to grow SHM file");
+    return false;
+  }
+
+  void *mapped = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (mapped == MAP_FAILED) {
+    Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
+                        "Failed to mmap");
+    return false;
+  }
+  if (data)
+    munmap(data, capacity);
+  data = static_cast<uint8_t *>(mapped);
+  capacity = size;
+
+  if (pool) {
+    wl_shm_pool_resize(pool, size);
+  } else {
+    pool = wl_shm_create_pool(shm, fd, size);
+    if (!pool) {
+      Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
+                          "Failed to create SHM pool");
+      return false;
+    }
+  }
+
+  for (auto &buffer : buffers) {
+    buffer->rebind(data);
+  }
+  return true;
+}
+
+void BufferPool::resize(struct wl_shm *s, int w, int h) {
+  if (w <= 0 || h <= 0) {
+    Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::ERROR,
+                        "Invalid buffer dimensions");
+    return;
+  }
+  if (w == width && h == height && pool)
+    return;
+
+  shm = s;
+  reap_retired();
+  retire();
+  previous = nullptr;
+  width = w;
+  height = h;
+  buffer_size = static_cast<size_t>(width) * height * 4;
+
+  // room for double buffering up front, the third buffer grows the pool
+  ensure_capacity(buffer_size * 2);
+}
+
+Buffer *BufferPool::acquire() {
+  if (!is_valid())
+    return nullptr;
+  reap_retired();
+
+  for (auto &buffer : buffers) {
+    if (!buffer->is_busy())
+      return hand_out(buffer.get());
+  }
+
+  if (buffers.size() >= MAX_BUFFERS)
+    return nullptr;
+
+  size_t offset = buffers.size() * buffer_size;
+  if (!ensure_capacity(offset + buffer_size))
+    return nullptr;
+
+  auto buffer = std::make_unique<Buffer>();
+  if (!buffer->create(pool, data, offset, width, height, thread_count))
+    return nullptr;
+  buffer->on_release = [this](Buffer *) {
+    if (on_release)
+      on_release();
+  };
+
+  if (buffers.size() == 2) {
+    Lawnch::Logger::log("Renderer", Lawnch::Logger::LogLevel::DEBUG,
+                        "Compositor holds both buffers, adding a third");
+  }
+
+  buffers.push_back(std::move(buffer));
+  return hand_out(buffers.back().get());
+}
+
+Buffer *BufferPool::hand_out(Buffer *buffer) {
+  buffer->mark_busy();
+  return buffer;
+}
+
+void BufferPool::add_damage(const std::vector<BLRectI> &damage) {
+  for (auto &buffer : buffers) {
+    buffer->add_damage(damage);
+  }
+}
+
+} // namespace Lawnch::Core::Window::Render
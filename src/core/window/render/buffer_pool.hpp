@@ -0,0 +1,83 @@
+#pragma once
+
+#include "buffer.hpp"
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Lawnch::Core::Window::Render {
+
+// Hands out buffers the compositor is done with, all backed by a single
+// grow-only wl_shm_pool that survives resizes. Two buffers cover the normal
+// case; a third is only added when both are still held by the compositor.
+// Buffers still held across a resize keep their memory, the pool moves on to
+// a fresh file until they are released.
+class BufferPool {
+public:
+  static constexpr size_t MAX_BUFFERS = 3;
+
+  BufferPool();
+  ~BufferPool();
+
+  BufferPool(const BufferPool &) = delete;
+  BufferPool &operator=(const BufferPool &) = delete;
+
+  void resize(struct wl_shm *shm, int width, int height);
+  // blend2d worker threads for buffers created from now on, 0 renders on
+  // the calling thread
+  void set_thread_count(uint32_t count) { thread_count = count; }
+  void destroy();
+
+  // nullptr while every buffer is still held by the compositor; on_release
+  // fires once one comes back
+  Buffer *acquire();
+  // the buffer last committed, i.e. the last frame that was presented; may
+  // be the one just acquired, nullptr after a resize
+  Buffer *get_previous() const { return previous; }
+  // call once `buffer` is committed to the surface
+  void set_presented(Buffer *buffer) { previous = buffer; }
+  // record a frame's damage against every buffer, see Buffer::add_damage
+  void add_damage(const std::vector<BLRectI> &damage);
+
+  bool is_valid() const { return width > 0 && height > 0 && pool; }
+  int get_width() const { return width; }
+  int get_height() const { return height; }
+
+  std::function<void()> on_release;
+
+private:
+  // memory of an earlier size the compositor may still be reading from
+  struct Retired {
+    struct wl_shm_pool *pool = nullptr;
+    int fd = -1;
+    uint8_t *data = nullptr;
+    size_t capacity = 0;
+    std::vector<std::unique_ptr<Buffer>> buffers;
+  };
+
+  bool ensure_capacity(size_t size);
+  void retire();
+  // frees retired memory once none of its buffers is busy, `all` does so
+  // regardless
+  void reap_retired(bool all = false);
+  static void free_memory(struct wl_shm_pool *&pool, int &fd, uint8_t *&data,
+                          size_t capacity);
+
+  struct wl_shm *shm = nullptr;
+  struct wl_shm_pool *pool = nullptr;
+  int fd = -1;
+  uint8_t *data = nullptr;
+  size_t capacity = 0;
+
+  int width = 0;
+  int height = 0;
+  size_t buffer_size = 0;
+  uint32_t thread_count = 0;
+  std::vector<std::unique_ptr<Buffer>> buffers;
+  std::vector<Retired> retired;
+  Buffer *previous = nullptr;
+
+  Buffer *hand_out(Buffer *buffer);
+};
+
+} // namespace Lawnch::Core::Window::Render
@@ -6,6 +6,7 @@ namespace Lawnch::Core::Window::Render::Components {
 ComponentResult Background::draw(ComponentContext &context) {
   auto &ctx = context.ctx;
   auto &cfg = context.cfg;
+  auto &style = context.style;
   int width = context.window_width;
   int height = context.window_height;
 
@@ -17,12 +18,10 @@ ComponentResult Background::draw(ComponentContext &context) {
   BLRoundRect rect =
       Lawnch::Gfx::rounded_rect(0, 0, width, height, cfg.window_border_radius);
 
-  auto bg = cfg.window_background;
-  ctx.set_fill_style(Lawnch::Gfx::toBLColor(bg));
+  ctx.set_fill_style(style.window_background);
   ctx.fill_round_rect(rect);
 
-  auto border = cfg.window_border_color;
-  ctx.set_stroke_style(Lawnch::Gfx::toBLColor(border));
+  ctx.set_stroke_style(style.window_border_color);
   ctx.set_stroke_width(cfg.window_border_width);
   ctx.stroke_round_rect(rect);
 
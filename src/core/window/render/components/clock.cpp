@@ -7,52 +7,52 @@
 
 namespace Lawnch::Core::Window::Render::Components {
 
+std::string Clock::format_time(const Config::Config &cfg) {
+  auto now = std::chrono::system_clock::now();
+  std::time_t time_t_now = std::chrono::system_clock::to_time_t(now);
+  std::tm *local_tm = std::localtime(&time_t_now);
+
+  char time_buffer[128];
+  std::strftime(time_buffer, sizeof(time_buffer), cfg.clock_format.c_str(),
+                local_tm);
+  return std::string(time_buffer);
+}
+
 ComponentResult Clock::draw(ComponentContext &context) {
   auto &ctx = context.ctx;
   auto &cfg = context.cfg;
+  auto &style = context.style;
 
   if (!cfg.clock_enable) {
     return {0, 0};
   }
 
-  auto now = std::chrono::system_clock::now();
-  std::time_t time_t_now = std::chrono::system_clock::to_time_t(now);
-  std::tm *local_tm = std::localtime(&time_t_now);
-
-  char time_buffer[128];
-  std::strftime(time_buffer, sizeof(time_buffer), cfg.clock_format.c_str(),
-                local_tm);
-  std::string time_text(time_buffer);
+  std::string time_text = format_time(cfg);
 
-  BLFont font = Lawnch::Gfx::get_font(
-      cfg.clock_font_family, cfg.clock_font_size, cfg.clock_font_weight);
-  BLFontMetrics fm = font.metrics();
+  const BLFont &font = style.clock_font.font;
+  const BLFontMetrics &fm = style.clock_font.metrics;
 
-  double clock_h =
-      fm.ascent + fm.descent + cfg.clock_padding.top + cfg.clock_padding.bottom;
+  double clock_h = style.clock_font.height + cfg.clock_padding.top +
+                   cfg.clock_padding.bottom;
 
   double text_y = context.y + cfg.clock_padding.top + fm.ascent;
   double text_x = context.x + cfg.clock_padding.left;
 
-  BLGlyphBuffer gb;
-  gb.set_utf8_text(time_text.c_str(), time_text.size());
-  font.shape(gb);
-  BLTextMetrics tm;
-  font.get_text_metrics(gb, tm);
+  auto run = Lawnch::Gfx::shape_text(font, time_text);
 
   double avail_w =
       context.available_w - cfg.clock_padding.left - cfg.clock_padding.right;
 
-  if (cfg.clock_align == "center") {
+  if (style.clock_align == Config::Align::Center) {
     text_x =
-        context.x + cfg.clock_padding.left + (avail_w - tm.advance.x) / 2.0;
-  } else if (cfg.clock_align == "right") {
+        context.x + cfg.clock_padding.left + (avail_w - run->width) / 2.0;
+  } else if (style.clock_align == Config::Align::Right) {
     text_x = context.x + context.available_w - cfg.clock_padding.right -
-             tm.advance.x;
+             run->width;
   }
 
-  ctx.set_fill_style(Lawnch::Gfx::toBLColor(cfg.clock_text));
-  ctx.fill_utf8_text(BLPoint(text_x, text_y), font, time_text.c_str());
+  ctx.set_fill_style(style.clock_text);
+  Lawnch::Gfx::fill_text_run(ctx, BLPoint(text_x, text_y), font, *run);
 
   return {context.available_w, clock_h};
 }
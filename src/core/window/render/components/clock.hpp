@@ -8,6 +8,8 @@ class Clock : public ComponentBase {
 public:
   ComponentResult draw(ComponentContext &context) override;
   std::string name() const override { return "clock"; }
+
+  static std::string format_time(const Config::Config &cfg);
 };
 
 } // namespace Lawnch::Core::Window::Render::Components
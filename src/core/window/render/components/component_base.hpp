@@ -4,6 +4,7 @@
 #include <string>
 
 #include "../../../config/config.hpp"
+#include "../../../config/style.hpp"
 #include "../../../search/interface.hpp"
 
 namespace Lawnch::Core::Window::Render {
@@ -15,12 +16,16 @@ struct ComponentContext {
   int window_width;
   int window_height;
   const Config::Config &cfg;
+  const Config::Style &style;
   const RenderState &state;
 
   double x;
   double y;
   double available_w;
   double available_h;
+
+  // area being repainted, empty when drawing everything
+  BLRect damage{};
 };
 
 struct ComponentResult {
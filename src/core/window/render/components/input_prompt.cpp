@@ -3,29 +3,22 @@
 
 namespace Lawnch::Core::Window::Render::Components {
 
-double InputPrompt::calculate_width(const Config::Config &cfg) {
+double InputPrompt::calculate_width(const Config::Config &cfg,
+                                    const Config::Style &style) {
   if (!cfg.input_prompt_enable || cfg.input_prompt_text.empty()) {
     return 0;
   }
 
-  BLFont font = Lawnch::Gfx::get_font(cfg.input_prompt_font_family,
-                                      cfg.input_prompt_font_size,
-                                      cfg.input_prompt_font_weight);
-
-  BLGlyphBuffer gb;
-  gb.set_utf8_text(cfg.input_prompt_text.c_str());
-  font.shape(gb);
-
-  BLTextMetrics tm;
-  font.get_text_metrics(gb, tm);
-
-  return tm.advance.x + cfg.input_prompt_padding.left +
+  auto run = Lawnch::Gfx::shape_text(style.input_prompt_font.font,
+                                     cfg.input_prompt_text);
+  return run->width + cfg.input_prompt_padding.left +
          cfg.input_prompt_padding.right;
 }
 
 ComponentResult InputPrompt::draw(ComponentContext &context) {
   auto &ctx = context.ctx;
   auto &cfg = context.cfg;
+  auto &style = context.style;
 
   if (!cfg.input_prompt_enable || cfg.input_prompt_text.empty()) {
     return {0, 0};
@@ -35,21 +28,17 @@ ComponentResult InputPrompt::draw(ComponentContext &context) {
       context.x, context.y, context.available_w, context.available_h,
       cfg.input_prompt_border_radius);
   if (cfg.input_prompt_background.a > 0) {
-    ctx.set_fill_style(
-        Lawnch::Gfx::toBLColor(cfg.input_prompt_background));
+    ctx.set_fill_style(style.input_prompt_background);
     ctx.fill_round_rect(rect);
   }
   if (cfg.input_prompt_border_width > 0) {
-    ctx.set_stroke_style(Lawnch::Gfx::toBLColor(cfg.input_prompt_border_color));
+    ctx.set_stroke_style(style.input_prompt_border_color);
     ctx.set_stroke_width(cfg.input_prompt_border_width);
     ctx.stroke_round_rect(rect);
   }
 
-  BLFont font = Lawnch::Gfx::get_font(cfg.input_prompt_font_family,
-                                      cfg.input_prompt_font_size,
-                                      cfg.input_prompt_font_weight);
-
-  BLFontMetrics fm = font.metrics();
+  const BLFont &font = style.input_prompt_font.font;
+  const BLFontMetrics &fm = style.input_prompt_font.metrics;
 
   double content_h = context.available_h - cfg.input_prompt_padding.top -
                      cfg.input_prompt_padding.bottom;
@@ -59,9 +48,9 @@ ComponentResult InputPrompt::draw(ComponentContext &context) {
   double text_y =
       content_y + (content_h - (fm.ascent + fm.descent)) / 2.0 + fm.ascent;
 
-  ctx.set_fill_style(Lawnch::Gfx::toBLColor(cfg.input_prompt_color));
-  ctx.fill_utf8_text(BLPoint(text_x, text_y), font,
-                     cfg.input_prompt_text.c_str());
+  ctx.set_fill_style(style.input_prompt_color);
+  auto run = Lawnch::Gfx::shape_text(font, cfg.input_prompt_text);
+  Lawnch::Gfx::fill_text_run(ctx, BLPoint(text_x, text_y), font, *run);
 
   return {context.available_w, context.available_h};
 }
@@ -8,7 +8,8 @@ class InputPrompt : public ComponentBase {
 public:
   ComponentResult draw(ComponentContext &context) override;
   std::string name() const override { return "input_prompt"; }
-  double calculate_width(const Config::Config &cfg);
+  double calculate_width(const Config::Config &cfg,
+                         const Config::Style &style);
 };
 
 } // namespace Lawnch::Core::Window::Render::Components
@@ -4,42 +4,16 @@
 #include "../../../icons/manager.hpp"
 #include "../render_state.hpp"
 #include <algorithm>
-#include <deque>
 #include <functional>
 #include <iostream>
 #include <sstream>
-#include <unordered_map>
 
 namespace Lawnch::Core::Window::Render::Components {
 
 namespace {
 
-std::unordered_map<std::string, BLImage> preview_lru;
-std::deque<std::string> preview_lru_order;
-constexpr size_t LRU_MAX = 5;
-
-BLImage *get_cached_preview(const std::string &path) {
-  auto it = preview_lru.find(path);
-  if (it != preview_lru.end()) {
-    auto pos =
-        std::find(preview_lru_order.begin(), preview_lru_order.end(), path);
-    if (pos != preview_lru_order.end()) {
-      preview_lru_order.erase(pos);
-      preview_lru_order.push_front(path);
-    }
-    return &it->second;
-  }
-  return nullptr;
-}
-
-void cache_preview(const std::string &path, BLImage img) {
-  if (preview_lru.size() >= LRU_MAX && !preview_lru_order.empty()) {
-    preview_lru.erase(preview_lru_order.back());
-    preview_lru_order.pop_back();
-  }
-  preview_lru_order.push_front(path);
-  preview_lru[path] = std::move(img);
-}
+// rows on either side of the selection whose images are loaded ahead
+constexpr int PREFETCH_DISTANCE = 2;
 
 class PreviewLayout {
 public:
@@ -53,9 +27,9 @@ public:
     bool is_group = false;
   };
 
-  PreviewLayout(const Config::Config &cfg, const Search::SearchResult &selected,
-                double available_w)
-      : cfg(cfg), selected(selected), available_w(available_w) {
+  PreviewLayout(const Config::Config &cfg, const Config::Style &style,
+                const Search::SearchResult &selected, double available_w)
+      : cfg(cfg), style(style), selected(selected), available_w(available_w) {
     parse_layout_string();
     resolve_item_properties();
     calculate_layout_dimensions();
@@ -80,7 +54,7 @@ public:
     double preview_w = available_w;
 
     if (cfg.preview_background.a > 0) {
-      ctx.set_fill_style(Lawnch::Gfx::toBLColor(cfg.preview_background));
+      ctx.set_fill_style(style.preview_background);
       ctx.fill_rect(x, y, preview_w, preview_h);
     }
 
@@ -111,6 +85,7 @@ public:
 
 private:
   const Config::Config &cfg;
+  const Config::Style &style;
   const Search::SearchResult &selected;
   double available_w;
   std::vector<LayoutItem> layout;
@@ -147,26 +122,11 @@ private:
           check_image(child);
       } else if (item.type == "preview_image") {
         has_preview_image = true;
-        if (!selected.preview_image_path.empty()) {
-          std::filesystem::path image_path =
-              ImageCache::ImageCache::Instance().get_image(
-                  selected.preview_image_path, cfg.preview_image_size,
-                  cfg.preview_image_size);
-
-          if (!image_path.empty()) {
-            if (BLImage *cached = get_cached_preview(image_path.string())) {
-              preview_image = *cached;
-            } else {
-              if (preview_image.read_from_file(image_path.string().c_str()) ==
-                  BL_SUCCESS) {
-                cache_preview(image_path.string(), preview_image);
-              } else {
-                image_failed = true;
-              }
-            }
-          } else {
-            image_failed = true;
-          }
+        auto image = ImageCache::ImageCache::Instance().get_image(
+            selected.preview_image_path, cfg.preview_image_size,
+            cfg.preview_image_size);
+        if (image) {
+          preview_image = *image;
         } else {
           image_failed = true;
         }
@@ -279,14 +239,8 @@ private:
         item.width = item.height = 0;
         return;
       }
-      BLFont font = is_name ? Gfx::get_font(cfg.preview_title_font_family,
-                                            cfg.preview_title_font_size,
-                                            cfg.preview_title_font_weight)
-                            : Gfx::get_font(cfg.preview_title_font_family,
-                                            cfg.preview_description_font_size,
-                                            cfg.preview_description_font_weight);
-      BLFontMetrics fm = font.metrics();
-      item.height = fm.ascent + fm.descent;
+      item.height = is_name ? style.preview_title_font.height
+                            : style.preview_description_font.height;
     }
   }
 
@@ -322,13 +276,12 @@ private:
         ctx.blit_image(BLPoint(draw_x, draw_y), preview_image);
       }
     } else if (item.type == "name") {
-      draw_text(ctx, selected.name, x, y, w_avail, cfg.preview_title_font_family,
-                cfg.preview_title_font_size, cfg.preview_title_font_weight,
-                cfg.preview_title_color);
+      draw_text(ctx, selected.name, x, y, w_avail, style.preview_title_font,
+                style.preview_title_color);
     } else if (item.type == "comment") {
       draw_text(ctx, selected.comment, x, y, w_avail,
-                cfg.preview_title_font_family, cfg.preview_description_font_size,
-                cfg.preview_description_font_weight, cfg.preview_description_color);
+                style.preview_description_font,
+                style.preview_description_color);
     }
   }
 
@@ -339,27 +292,23 @@ private:
   }
 
   void draw_text(BLContext &ctx, const std::string &text_content, double x,
-                 double y, double w_avail, const std::string &family, int size,
-                 const std::string &weight, const Config::Color &color) {
-    BLFont font = Gfx::get_font(family, size, weight);
-    BLFontMetrics fm = font.metrics();
+                 double y, double w_avail, const Config::StyleFont &style_font,
+                 const BLRgba32 &color) {
+    const BLFont &font = style_font.font;
+    const BLFontMetrics &fm = style_font.metrics;
     std::string text = Gfx::truncate_text(text_content, font, w_avail);
+    auto run = Gfx::shape_text(font, text);
 
-    BLTextMetrics tm;
-    BLGlyphBuffer gb;
-    gb.set_utf8_text(text.c_str());
-    font.shape(gb);
-    font.get_text_metrics(gb, tm);
-
-    double text_x = x + (w_avail - tm.advance.x) / 2.0;
-    ctx.set_fill_style(Gfx::toBLColor(color));
-    ctx.fill_utf8_text(BLPoint(text_x, y + fm.ascent), font, text.c_str());
+    double text_x = x + (w_avail - run->width) / 2.0;
+    ctx.set_fill_style(color);
+    Gfx::fill_text_run(ctx, BLPoint(text_x, y + fm.ascent), font, *run);
   }
 };
 
 } // namespace
 
 double Preview::get_height(const Config::Config &cfg,
+                           const Config::Style &style,
                            const RenderState &state) {
   if (!cfg.preview_enable || state.results.empty() ||
       state.selected_index < 0 ||
@@ -367,13 +316,17 @@ double Preview::get_height(const Config::Config &cfg,
     return 0;
   }
   const auto &selected = state.results[state.selected_index];
-  PreviewLayout layout(cfg, selected, 1000.0);
+  PreviewLayout layout(cfg, style, selected, 1000.0);
   return layout.get_total_height();
 }
 
 ComponentResult Preview::draw(ComponentContext &context) {
   auto &state = context.state;
 
+  // whatever an earlier selection queued is no longer needed unless it is
+  // asked for again below
+  ImageCache::ImageCache::Instance().begin_requests();
+
   if (!context.cfg.preview_enable || state.results.empty() ||
       state.selected_index < 0 ||
       state.selected_index >= (int)state.results.size()) {
@@ -381,13 +334,28 @@ ComponentResult Preview::draw(ComponentContext &context) {
   }
 
   const auto &selected = state.results[state.selected_index];
-  PreviewLayout layout(context.cfg, selected, context.available_w);
+  PreviewLayout layout(context.cfg, context.style, selected,
+                       context.available_w);
 
   double total_height = layout.get_total_height();
   if (total_height > 0) {
     layout.draw(context.ctx, context.x, context.y);
   }
 
+  // the rows around the selection are the likely next previews, nearest
+  // first
+  for (int distance = 1; distance <= PREFETCH_DISTANCE; ++distance) {
+    for (int index : {state.selected_index - distance,
+                      state.selected_index + distance}) {
+      if (index >= 0 && index < (int)state.results.size()) {
+        ImageCache::ImageCache::Instance().prefetch(
+            state.results[index].preview_image_path,
+            context.cfg.preview_image_size, context.cfg.preview_image_size,
+            distance);
+      }
+    }
+  }
+
   return {context.available_w, total_height};
 }
 
@@ -11,7 +11,9 @@ public:
   ComponentResult draw(ComponentContext &context) override;
   std::string name() const override { return "preview"; }
 
-  static double get_height(const Config::Config &cfg, const RenderState &state);
+  static double get_height(const Config::Config &cfg,
+                           const Config::Style &style,
+                           const RenderState &state);
 };
 
 } // namespace Lawnch::Core::Window::Render::Components
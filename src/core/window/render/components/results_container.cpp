@@ -1,28 +1,23 @@
 #include "results_container.hpp"
 #include "../../../../helpers/gfx.hpp"
 #include "../../../icons/manager.hpp"
+#include "../damage.hpp"
 #include "../render_state.hpp"
 #include <algorithm>
 #include <cctype>
 #include <cmath>
+#include <cstdlib>
+#include <cstring>
 
 namespace Lawnch::Core::Window::Render::Components {
 
-void ResultsContainer::update_metrics(const Config::Config &cfg) const {
-  BLFont font = Lawnch::Gfx::get_font(cfg.result_item_font_family,
-                                      cfg.result_item_font_size,
-                                      cfg.result_item_font_weight);
-  BLFontMetrics metrics = font.metrics();
-  double name_h = metrics.ascent + metrics.descent;
+void ResultsContainer::update_metrics(const Config::Config &cfg,
+                                      const Config::Style &style) const {
+  double name_h = style.result_item_font.height;
 
   double comment_h = 0;
-  if (cfg.result_item_comment_enable) {
-    BLFont cfont = Lawnch::Gfx::get_font(cfg.result_item_font_family,
-                                         cfg.result_item_comment_font_size,
-                                         cfg.result_item_comment_font_weight);
-    BLFontMetrics cmetrics = cfont.metrics();
-    comment_h = cmetrics.ascent + cmetrics.descent;
-  }
+  if (cfg.result_item_comment_enable)
+    comment_h = style.result_item_comment_font.height;
 
   double text_gap = 4.0;
   double item_inner_h = name_h;
@@ -37,40 +32,142 @@ void ResultsContainer::update_metrics(const Config::Config &cfg) const {
   metrics_valid = true;
 }
 
-double ResultsContainer::get_item_height(const Config::Config &cfg) const {
+double ResultsContainer::row_top(int rel_index) const {
+  const auto &l = row_layout;
+  if (l.reverse) {
+    int reverse_rel_i = l.actual_visible - 1 - rel_index;
+    return std::floor(l.items_start_y + l.bottom_offset +
+                      reverse_rel_i * l.item_height);
+  }
+  return std::floor(l.items_start_y + rel_index * l.item_height);
+}
+
+// Copies `lines` pixel rows of the span [x0, x1) from src_y in src to dst_y
+// in dst, in an order that is safe when both are the same image.
+static void move_lines(BLImageData &dst, const BLImageData &src, int x0,
+                       int x1, int src_y, int dst_y, int lines, int min_y,
+                       int max_y) {
+  size_t bytes = (size_t)(x1 - x0) * 4;
+  for (int n = 0; n < lines; ++n) {
+    int l = dst_y > src_y ? lines - 1 - n : n;
+    int sy = src_y + l;
+    int ty = dst_y + l;
+    if (sy < min_y || sy >= max_y || ty < min_y || ty >= max_y)
+      continue;
+    auto *to = static_cast<uint8_t *>(dst.pixel_data) + ty * dst.stride;
+    auto *from =
+        static_cast<const uint8_t *>(src.pixel_data) + sy * src.stride;
+    std::memmove(to + x0 * 4, from + x0 * 4, bytes);
+  }
+}
+
+std::optional<std::vector<BLRect>>
+ResultsContainer::scroll_rows(BLImageData &dst, const BLImageData &src,
+                              const RenderState &state,
+                              int previous_selected) const {
+  const auto &l = row_layout;
+  int old_offset = l.scroll_offset;
+  int new_offset = state.scroll_offset;
+  int delta = new_offset - old_offset;
+  if (!l.valid || delta == 0 || std::abs(delta) >= l.visible_count)
+    return std::nullopt;
+
+  int total = (int)state.results.size();
+  int old_end = old_offset + l.actual_visible;
+  int new_end = std::min(total, new_offset + l.visible_count);
+  // a partly filled page lays rows out differently
+  if (new_end - new_offset != l.actual_visible)
+    return std::nullopt;
+
+  int width = std::min(dst.size.w, src.size.w);
+  int height = std::min(dst.size.h, src.size.h);
+  int x0 = std::max(0, (int)std::floor(l.content_x) - 1);
+  int x1 = std::min(width, (int)std::ceil(l.content_x + l.content_w) + 1);
+  int min_y = std::max(0, (int)std::floor(l.items_start_y));
+  int max_y = std::min(
+      height,
+      (int)std::ceil(l.items_start_y + l.visible_count * l.item_height));
+  int band = (int)std::ceil(l.item_height);
+  if (x1 <= x0 || max_y <= min_y)
+    return std::nullopt;
+
+  // rows visible before and after, walked so no source row is overwritten
+  // before it has been moved
+  int first = std::max(old_offset, new_offset);
+  int last = std::min(old_end, new_end);
+  bool moving_down =
+      row_top(first - new_offset) > row_top(first - old_offset);
+  for (int n = 0; n < last - first; ++n) {
+    int i = moving_down ? last - 1 - n : first + n;
+    int from = (int)row_top(i - old_offset);
+    int to = (int)row_top(i - new_offset);
+    move_lines(dst, src, x0, x1, from, to, band, min_y, max_y);
+  }
+
+  std::vector<BLRect> repaint;
+  auto add_row = [&](int i) {
+    if (i >= new_offset && i < new_end) {
+      repaint.emplace_back(l.content_x, row_top(i - new_offset), l.content_w,
+                           l.item_h);
+    }
+  };
+  for (int i = new_offset; i < new_end; ++i) {
+    if (i < old_offset || i >= old_end)
+      add_row(i);
+  }
+  add_row(previous_selected);
+  add_row(state.selected_index);
+  if (l.scrollbar.w > 0)
+    repaint.push_back(l.scrollbar);
+  return repaint;
+}
+
+const BLRect *ResultsContainer::get_row_rect(int index) const {
+  for (const auto &[i, rect] : row_rects) {
+    if (i == index)
+      return &rect;
+  }
+  return nullptr;
+}
+
+double ResultsContainer::get_item_height(const Config::Config &cfg,
+                                         const Config::Style &style) const {
   if (!metrics_valid)
-    update_metrics(cfg);
+    update_metrics(cfg, style);
   return cached_item_height;
 }
 
 void ResultsContainer::draw_result_item(BLContext &ctx,
                                         const Config::Config &cfg,
+                                        const Config::Style &style,
                                         const Search::SearchResult &result,
                                         double item_x, double item_y,
                                         double item_w, double item_h,
                                         bool is_selected,
                                         const std::string &search_text) const {
+  BLFont font = style.result_item_font.font;
+  const BLFontMetrics &fm = style.result_item_font.metrics;
 
-  BLFont font = Lawnch::Gfx::get_font(cfg.result_item_font_family,
-                                      cfg.result_item_font_size,
-                                      cfg.result_item_font_weight);
-  BLFontMetrics fm = font.metrics();
-
-  BLFont comment_font = Lawnch::Gfx::get_font(
-      cfg.result_item_font_family, cfg.result_item_comment_font_size,
-      cfg.result_item_comment_font_weight);
-  BLFontMetrics cm = comment_font.metrics();
+  BLFont comment_font = style.result_item_comment_font.font;
+  const BLFontMetrics &cm = style.result_item_comment_font.metrics;
 
   double center_y = item_y + (item_h / 2.0);
 
-  auto bg_color = is_selected ? cfg.result_item_selected_background
-                              : cfg.result_item_background;
-  auto border_color = is_selected ? cfg.result_item_selected_border_color
-                                  : cfg.result_item_border_color;
-  auto text_color = is_selected ? cfg.result_item_selected_text
-                                : cfg.result_item_text;
-  auto comment_color_cfg = is_selected ? cfg.result_item_selected_comment
-                                       : cfg.result_item_comment_color;
+  auto bg_alpha = is_selected ? cfg.result_item_selected_background.a
+                              : cfg.result_item_background.a;
+  auto border_alpha = is_selected ? cfg.result_item_selected_border_color.a
+                                  : cfg.result_item_border_color.a;
+  const BLRgba32 &bg_color = is_selected
+                                 ? style.result_item_selected_background
+                                 : style.result_item_background;
+  const BLRgba32 &border_color = is_selected
+                                     ? style.result_item_selected_border_color
+                                     : style.result_item_border_color;
+  const BLRgba32 &text_color =
+      is_selected ? style.result_item_selected_text : style.result_item_text;
+  const BLRgba32 &comment_color = is_selected
+                                      ? style.result_item_selected_comment
+                                      : style.result_item_comment_color;
 
   int radius = is_selected ? cfg.result_item_selected_border_radius
                            : cfg.result_item_border_radius;
@@ -87,13 +184,13 @@ void ResultsContainer::draw_result_item(BLContext &ctx,
   BLRoundRect item_rect = Lawnch::Gfx::rounded_rect(
       draw_x_rect, draw_y_rect, draw_w_rect, draw_h_rect, radius);
 
-  if (bg_color.a > 0) {
-    ctx.set_fill_style(Lawnch::Gfx::toBLColor(bg_color));
+  if (bg_alpha > 0) {
+    ctx.set_fill_style(bg_color);
     ctx.fill_round_rect(item_rect);
   }
 
-  if (border_w > 0 && border_color.a > 0) {
-    ctx.set_stroke_style(Lawnch::Gfx::toBLColor(border_color));
+  if (border_w > 0 && border_alpha > 0) {
+    ctx.set_stroke_style(border_color);
     ctx.set_stroke_width(border_w);
     ctx.stroke_round_rect(item_rect);
   }
@@ -118,12 +215,13 @@ void ResultsContainer::draw_result_item(BLContext &ctx,
   }
 
   if (draw_w > 0) {
-    ctx.set_fill_style(Lawnch::Gfx::toBLColor(text_color));
+    ctx.set_fill_style(text_color);
     double text_x_pos = draw_x;
+    auto align = style.result_item_align;
 
-    if (cfg.result_item_align == "center") {
+    if (align == Config::Align::Center) {
       text_x_pos = item_x + (item_w / 2.0);
-    } else if (cfg.result_item_align == "right") {
+    } else if (align == Config::Align::Right) {
       text_x_pos = draw_x_rect + draw_w_rect - cfg.result_item_padding.right;
     }
 
@@ -145,34 +243,25 @@ void ResultsContainer::draw_result_item(BLContext &ctx,
     ctx.clip_to_rect(BLRect(draw_x, draw_y_rect, draw_w, draw_h_rect));
 
     std::string display_name = result.name;
-    if (cfg.result_item_align != "center" &&
-        cfg.result_item_align != "right") {
+    if (align == Config::Align::Left) {
       display_name = Lawnch::Gfx::truncate_text(result.name, font, draw_w);
     }
 
+    auto name_run = Lawnch::Gfx::shape_text(font, display_name);
     double final_text_x = text_x_pos;
-    if (cfg.result_item_align == "center" ||
-        cfg.result_item_align == "right") {
-      BLGlyphBuffer gb;
-      gb.set_utf8_text(display_name.c_str(), display_name.size());
-      font.shape(gb);
-      BLTextMetrics tm;
-      font.get_text_metrics(gb, tm);
-
-      if (cfg.result_item_align == "center") {
-        final_text_x -= (tm.advance.x / 2.0);
+    if (align != Config::Align::Left) {
+      if (align == Config::Align::Center) {
+        final_text_x -= (name_run->width / 2.0);
       } else {
-        final_text_x -= tm.advance.x;
+        final_text_x -= name_run->width;
       }
     }
 
     if (cfg.result_item_highlight_enable && !search_text.empty()) {
-      auto highlight_color = is_selected
-                                 ? cfg.result_item_selected_highlight
-                                 : cfg.result_item_highlight_color;
-      BLFont highlight_font = Lawnch::Gfx::get_font(
-          cfg.result_item_font_family, cfg.result_item_font_size,
-          cfg.result_item_highlight_font_weight);
+      const BLRgba32 &highlight_color =
+          is_selected ? style.result_item_selected_highlight
+                      : style.result_item_highlight_color;
+      const BLFont &highlight_font = style.result_item_highlight_font.font;
 
       std::string query_term = search_text;
       if (!query_term.empty() && query_term[0] == ':') {
@@ -208,55 +297,67 @@ void ResultsContainer::draw_result_item(BLContext &ctx,
         }
       }
 
+      // Draw runs of glyphs that are all matched or all unmatched. Plain
+      // runs are slices of the already shaped name; matched runs only need
+      // their own (cached) shaping when the highlight weight is another face.
+      const auto &clusters = name_run->clusters;
+      size_t glyph_count = clusters.size();
+      bool same_face =
+          highlight_font.face().unique_id() == font.face().unique_id();
+      auto is_matched = [&](size_t glyph) {
+        return clusters[glyph] < highlight_mask.size() &&
+               highlight_mask[clusters[glyph]];
+      };
       double x_pos = final_text_x;
-      for (size_t i = 0; i < display_name.size(); ++i) {
-        std::string ch(1, display_name[i]);
-        BLFont &char_font = highlight_mask[i] ? highlight_font : font;
-        auto char_color = highlight_mask[i] ? highlight_color : text_color;
-
-        ctx.set_fill_style(Lawnch::Gfx::toBLColor(char_color));
-        ctx.fill_utf8_text(BLPoint(x_pos, name_y), char_font, ch.c_str());
-
-        BLGlyphBuffer char_gb;
-        char_gb.set_utf8_text(ch.c_str());
-        char_font.shape(char_gb);
-        BLTextMetrics char_tm;
-        char_font.get_text_metrics(char_gb, char_tm);
-        x_pos += char_tm.advance.x;
+      size_t first = 0;
+      while (first < glyph_count) {
+        bool matched = is_matched(first);
+        size_t last = first + 1;
+        while (last < glyph_count && is_matched(last) == matched)
+          ++last;
+
+        ctx.set_fill_style(matched ? highlight_color : text_color);
+        if (!matched || same_face) {
+          double start = first > 0 ? name_run->advances[first - 1] : 0;
+          Lawnch::Gfx::fill_text_run(ctx, BLPoint(x_pos, name_y), font,
+                                     *name_run, first, last - first);
+          x_pos += name_run->advances[last - 1] - start;
+        } else {
+          size_t begin = std::min<size_t>(clusters[first], display_name.size());
+          size_t end =
+              last < glyph_count ? clusters[last] : display_name.size();
+          auto matched_run = Lawnch::Gfx::shape_text(
+              highlight_font, display_name.substr(begin, end - begin));
+          Lawnch::Gfx::fill_text_run(ctx, BLPoint(x_pos, name_y),
+                                     highlight_font, *matched_run);
+          x_pos += matched_run->width;
+        }
+        first = last;
       }
     } else {
-      ctx.fill_utf8_text(BLPoint(final_text_x, name_y), font,
-                         display_name.c_str());
+      Lawnch::Gfx::fill_text_run(ctx, BLPoint(final_text_x, name_y), font,
+                                 *name_run);
     }
 
     if (cfg.result_item_comment_enable && !result.comment.empty()) {
-      ctx.set_fill_style(Lawnch::Gfx::toBLColor(comment_color_cfg));
+      ctx.set_fill_style(comment_color);
 
       std::string display_comment = result.comment;
-      if (cfg.result_item_align != "center" &&
-          cfg.result_item_align != "right") {
+      if (align == Config::Align::Left) {
         display_comment =
             Lawnch::Gfx::truncate_text(result.comment, comment_font, draw_w);
       }
 
+      auto comment_run = Lawnch::Gfx::shape_text(comment_font, display_comment);
       double final_comment_x = text_x_pos;
-      if (cfg.result_item_align == "center" ||
-          cfg.result_item_align == "right") {
-        BLGlyphBuffer gb;
-        gb.set_utf8_text(display_comment.c_str(), display_comment.size());
-        comment_font.shape(gb);
-        BLTextMetrics tm;
-        comment_font.get_text_metrics(gb, tm);
-
-        if (cfg.result_item_align == "center") {
-          final_comment_x -= (tm.advance.x / 2.0);
-        } else {
-          final_comment_x -= tm.advance.x;
-        }
+      if (align == Config::Align::Center) {
+        final_comment_x -= (comment_run->width / 2.0);
+      } else if (align == Config::Align::Right) {
+        final_comment_x -= comment_run->width;
       }
 
-      ctx.fill_utf8_text(BLPoint(final_comment_x, comment_y), comment_font,
-                         display_comment.c_str());
+      Lawnch::Gfx::fill_text_run(ctx, BLPoint(final_comment_x, comment_y),
+                                 comment_font, *comment_run);
     }
 
     ctx.restore();
@@ -266,10 +367,11 @@ void ResultsContainer::draw_result_item(BLContext &ctx,
 ComponentResult ResultsContainer::draw(ComponentContext &context) {
   auto &ctx = context.ctx;
   auto &cfg = context.cfg;
+  auto &style = context.style;
   auto &state = context.state;
 
   if (!metrics_valid)
-    update_metrics(cfg);
+    update_metrics(cfg, style);
 
   double item_height = cached_item_height;
   if (item_height <= 0)
@@ -307,13 +409,13 @@ ComponentResult ResultsContainer::draw(ComponentContext &context) {
       context.available_h - cfg.results_margin.top - cfg.results_margin.bottom;
 
   if (cfg.results_background.a > 0) {
-    ctx.set_fill_style(Lawnch::Gfx::toBLColor(cfg.results_background));
+    ctx.set_fill_style(style.results_background);
     ctx.fill_round_rect(Lawnch::Gfx::rounded_rect(container_x, container_y,
                                                   container_w, container_h,
                                                   cfg.results_border_radius));
   }
   if (cfg.results_border_width > 0 && cfg.results_border_color.a > 0) {
-    ctx.set_stroke_style(Lawnch::Gfx::toBLColor(cfg.results_border_color));
+    ctx.set_stroke_style(style.results_border_color);
     ctx.set_stroke_width(cfg.results_border_width);
     ctx.stroke_round_rect(Lawnch::Gfx::rounded_rect(container_x, container_y,
                                                     container_w, container_h,
@@ -330,24 +432,33 @@ ComponentResult ResultsContainer::draw(ComponentContext &context) {
     bottom_offset = empty_slots * item_height;
   }
 
+  row_rects.clear();
+  row_layout.valid = true;
+  row_layout.items_start_y = items_start_y;
+  row_layout.item_height = item_height;
+  row_layout.item_h = std::floor(item_height - cfg.results_gap);
+  row_layout.content_x = content_x;
+  row_layout.content_w = content_w;
+  row_layout.bottom_offset = bottom_offset;
+  row_layout.visible_count = visible_count;
+  row_layout.actual_visible = actual_visible;
+  row_layout.scroll_offset = state.scroll_offset;
+  row_layout.reverse = cfg.results_reverse;
+  row_layout.scrollbar = BLRect();
+
   for (int i = state.scroll_offset; i < end_index; ++i) {
     const auto &res = state.results[i];
-    int rel_i = i - state.scroll_offset;
-
-    double item_y;
-    if (cfg.results_reverse) {
-      int reverse_rel_i = actual_visible - 1 - rel_i;
-      item_y = std::floor(items_start_y + bottom_offset +
-                          reverse_rel_i * item_height);
-    } else {
-      item_y = std::floor(items_start_y + rel_i * item_height);
-    }
-
-    double item_h = std::floor(item_height - cfg.results_gap);
+    double item_y = row_top(i - state.scroll_offset);
+    double item_h = row_layout.item_h;
     bool is_sel = (i == state.selected_index);
 
-    draw_result_item(ctx, cfg, res, content_x, item_y, content_w, item_h,
-                     is_sel, state.search_text);
+    BLRect row(content_x, item_y, content_w, item_h);
+    row_rects.emplace_back(i, row);
+    if (!Damage::intersects(row, context.damage))
+      continue;
+
+    draw_result_item(ctx, cfg, style, res, content_x, item_y, content_w,
+                     item_h, is_sel, state.search_text);
   }
 
   if (show_scrollbar) {
@@ -359,8 +470,7 @@ ComponentResult ResultsContainer::draw(ComponentContext &context) {
     double track_h = available_h;
 
     if (cfg.results_scrollbar_track.a > 0) {
-      ctx.set_fill_style(
-          Lawnch::Gfx::toBLColor(cfg.results_scrollbar_track));
+      ctx.set_fill_style(style.results_scrollbar_track);
       ctx.fill_round_rect(Lawnch::Gfx::rounded_rect(
           track_x, track_y, cfg.results_scrollbar_width, track_h,
           cfg.results_scrollbar_radius));
@@ -372,8 +482,10 @@ ComponentResult ResultsContainer::draw(ComponentContext &context) {
     double scroll_progress =
         (double)state.scroll_offset / (total_results - visible_count);
     double thumb_y = track_y + (scroll_progress * thumb_range);
+    row_layout.scrollbar =
+        BLRect(track_x, track_y, cfg.results_scrollbar_width, track_h);
 
-    ctx.set_fill_style(Lawnch::Gfx::toBLColor(cfg.results_scrollbar_thumb));
+    ctx.set_fill_style(style.results_scrollbar_thumb);
     ctx.fill_round_rect(
         Lawnch::Gfx::rounded_rect(track_x, thumb_y, cfg.results_scrollbar_width,
                                   thumb_h, cfg.results_scrollbar_radius));
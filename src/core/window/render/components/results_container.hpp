@@ -1,6 +1,9 @@
 #pragma once
 
 #include "component_base.hpp"
+#include <optional>
+#include <utility>
+#include <vector>
 
 namespace Lawnch::Core::Window::Render::Components {
 
@@ -8,15 +11,46 @@ class ResultsContainer : public ComponentBase {
 public:
   ComponentResult draw(ComponentContext &context) override;
   std::string name() const override { return "results"; }
-  double get_item_height(const Config::Config &cfg) const;
+  double get_item_height(const Config::Config &cfg,
+                         const Config::Style &style) const;
   void invalidate_metrics() { metrics_valid = false; }
+  // bounds of a result row as of the last draw, nullptr if it was not visible
+  const BLRect *get_row_rect(int index) const;
+
+  // Scroll fast path: moves the rows that stay visible from `src` (the last
+  // frame) to their new place in `dst` and returns the rects that still
+  // need drawing. nullopt when the last draw cannot be reused this way.
+  std::optional<std::vector<BLRect>>
+  scroll_rows(BLImageData &dst, const BLImageData &src,
+              const RenderState &state, int previous_selected) const;
 
 private:
   mutable double cached_item_height = 0;
   mutable bool metrics_valid = false;
+  std::vector<std::pair<int, BLRect>> row_rects;
+
+  // row geometry of the last draw
+  struct RowLayout {
+    bool valid = false;
+    double items_start_y = 0;
+    double item_height = 0;
+    double item_h = 0;
+    double content_x = 0;
+    double content_w = 0;
+    double bottom_offset = 0;
+    int visible_count = 0;
+    int actual_visible = 0;
+    int scroll_offset = 0;
+    bool reverse = false;
+    BLRect scrollbar{};
+  } row_layout;
+
+  double row_top(int rel_index) const;
 
-  void update_metrics(const Config::Config &cfg) const;
+  void update_metrics(const Config::Config &cfg,
+                      const Config::Style &style) const;
   void draw_result_item(BLContext &ctx, const Config::Config &cfg,
+                        const Config::Style &style,
                         const Search::SearchResult &result, double item_x,
                         double item_y, double item_w, double item_h,
                         bool is_selected, const std::string &search_text) const;
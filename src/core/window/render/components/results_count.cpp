@@ -8,17 +8,17 @@ namespace Lawnch::Core::Window::Render::Components {
 ComponentResult ResultsCount::draw(ComponentContext &context) {
   auto &ctx = context.ctx;
   auto &cfg = context.cfg;
+  auto &style = context.style;
   auto &state = context.state;
 
   if (!cfg.results_count_enable) {
     return {0, 0};
   }
 
-  BLFont count_font = Lawnch::Gfx::get_font(cfg.results_count_font_family,
-                                            cfg.results_count_font_size,
-                                            cfg.results_count_font_weight);
-  BLFontMetrics fm = count_font.metrics();
-  double count_h = fm.ascent + fm.descent + cfg.results_count_padding.top +
+  const BLFont &count_font = style.results_count_font.font;
+  const BLFontMetrics &fm = style.results_count_font.metrics;
+  double count_h = style.results_count_font.height +
+                   cfg.results_count_padding.top +
                    cfg.results_count_padding.bottom;
 
   std::string count_text =
@@ -28,25 +28,21 @@ ComponentResult ResultsCount::draw(ComponentContext &context) {
   double text_y = context.y + cfg.results_count_padding.top + fm.ascent;
   double text_x = context.x + cfg.results_count_padding.left;
 
-  BLGlyphBuffer gb;
-  gb.set_utf8_text(count_text.c_str(), count_text.size());
-  count_font.shape(gb);
-  BLTextMetrics tm;
-  count_font.get_text_metrics(gb, tm);
+  auto run = Lawnch::Gfx::shape_text(count_font, count_text);
 
   double avail_w = context.available_w - cfg.results_count_padding.left -
                    cfg.results_count_padding.right;
 
-  if (cfg.results_count_align == "center") {
+  if (style.results_count_align == Config::Align::Center) {
     text_x = context.x + cfg.results_count_padding.left +
-             (avail_w - tm.advance.x) / 2.0;
-  } else if (cfg.results_count_align == "right") {
+             (avail_w - run->width) / 2.0;
+  } else if (style.results_count_align == Config::Align::Right) {
     text_x = context.x + context.available_w - cfg.results_count_padding.right -
-             tm.advance.x;
+             run->width;
   }
 
-  ctx.set_fill_style(Lawnch::Gfx::toBLColor(cfg.results_count_text));
-  ctx.fill_utf8_text(BLPoint(text_x, text_y), count_font, count_text.c_str());
+  ctx.set_fill_style(style.results_count_text);
+  Lawnch::Gfx::fill_text_run(ctx, BLPoint(text_x, text_y), count_font, *run);
 
   return {context.available_w, count_h};
 }
@@ -0,0 +1,57 @@
+#include "damage.hpp"
+#include <algorithm>
+#include <cmath>
+
+namespace Lawnch::Core::Window::Render::Damage {
+
+BLRectI to_device(const BLRect &rect, int width, int height) {
+  int x0 = std::max(0, (int)std::floor(rect.x - MARGIN));
+  int y0 = std::max(0, (int)std::floor(rect.y - MARGIN));
+  int x1 = std::min(width, (int)std::ceil(rect.x + rect.w + MARGIN));
+  int y1 = std::min(height, (int)std::ceil(rect.y + rect.h + MARGIN));
+  return BLRectI(x0, y0, std::max(0, x1 - x0), std::max(0, y1 - y0));
+}
+
+bool intersects(const BLRect &rect, const BLRect &damage) {
+  if (damage.w <= 0 || damage.h <= 0)
+    return true;
+  return rect.x - MARGIN < damage.x + damage.w &&
+         damage.x < rect.x + rect.w + MARGIN &&
+         rect.y - MARGIN < damage.y + damage.h &&
+         damage.y < rect.y + rect.h + MARGIN;
+}
+
+static bool overlap(const BLRectI &a, const BLRectI &b) {
+  return a.x <= b.x + b.w && b.x <= a.x + a.w && a.y <= b.y + b.h &&
+         b.y <= a.y + a.h;
+}
+
+void merge(std::vector<BLRectI> &rects) {
+  rects.erase(
+      std::remove_if(rects.begin(), rects.end(),
+                     [](const BLRectI &r) { return r.w <= 0 || r.h <= 0; }),
+      rects.end());
+
+  bool merged = true;
+  while (merged) {
+    merged = false;
+    for (size_t i = 0; i < rects.size() && !merged; ++i) {
+      for (size_t j = i + 1; j < rects.size(); ++j) {
+        if (!overlap(rects[i], rects[j]))
+          continue;
+        const BLRectI &a = rects[i];
+        const BLRectI &b = rects[j];
+        int x0 = std::min(a.x, b.x);
+        int y0 = std::min(a.y, b.y);
+        int x1 = std::max(a.x + a.w, b.x + b.w);
+        int y1 = std::max(a.y + a.h, b.y + b.h);
+        rects[i] = BLRectI(x0, y0, x1 - x0, y1 - y0);
+        rects.erase(rects.begin() + j);
+        merged = true;
+        break;
+      }
+    }
+  }
+}
+
+} // namespace Lawnch::Core::Window::Render::Damage
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <blend2d.h>
+#include <vector>
+
+namespace Lawnch::Core::Window::Render::Damage {
+
+// Slack around every damaged rect so antialiased edges and strokes centered
+// on a component's bounds are repainted along with it.
+constexpr double MARGIN = 4.0;
+
+// Grow by MARGIN, snap outwards to whole pixels and clip to the surface.
+BLRectI to_device(const BLRect &rect, int width, int height);
+
+// A rect with no area stands for "everything".
+bool intersects(const BLRect &rect, const BLRect &damage);
+
+// Collapse overlapping rects into their bounding boxes.
+void merge(std::vector<BLRectI> &rects);
+
+} // namespace Lawnch::Core::Window::Render::Damage
@@ -0,0 +1,197 @@
+#include "layout.hpp"
+#include "components/preview.hpp"
+#include <algorithm>
+#include <set>
+
+namespace Lawnch::Core::Window::Render {
+
+static double estimate_component_height(const std::string &name,
+                                        const Config::Config &cfg,
+                                        const Config::Style &style,
+                                        const RenderState &state) {
+  if (name == "input") {
+    if (!cfg.input_visible)
+      return 0;
+    return style.input_font.height + cfg.input_padding.top +
+           cfg.input_padding.bottom + cfg.input_margin.top +
+           cfg.input_margin.bottom;
+  }
+  if (name == "input_prompt" && cfg.input_prompt_enable) {
+    return style.input_prompt_font.height + cfg.input_prompt_padding.top +
+           cfg.input_prompt_padding.bottom + cfg.input_prompt_margin.top +
+           cfg.input_prompt_margin.bottom;
+  }
+  if (name == "results_count" && cfg.results_count_enable) {
+    return style.results_count_font.height + cfg.results_count_padding.top +
+           cfg.results_count_padding.bottom + cfg.results_count_margin.top +
+           cfg.results_count_margin.bottom;
+  }
+  if (name == "clock" && cfg.clock_enable) {
+    return style.clock_font.height + cfg.clock_padding.top +
+           cfg.clock_padding.bottom + cfg.clock_margin.top +
+           cfg.clock_margin.bottom;
+  }
+  if (name == "preview" && cfg.preview_enable && !state.results.empty()) {
+    return Components::Preview::get_height(cfg, style, state) +
+           cfg.preview_margin.top + cfg.preview_margin.bottom;
+  }
+  return 0;
+}
+
+// Outer margins the layout applies itself; the results container and the
+// prompt handle their own.
+static Config::Padding component_margin(const std::string &name,
+                                const Config::Config &cfg) {
+  if (name == "input")
+    return cfg.input_margin;
+  if (name == "clock")
+    return cfg.clock_margin;
+  if (name == "results_count")
+    return cfg.results_count_margin;
+  if (name == "preview")
+    return cfg.preview_margin;
+  return {};
+}
+
+static bool is_component(const std::string &name) {
+  return name == "input" || name == "input_prompt" ||
+         name == "results_count" || name == "results" || name == "preview" ||
+         name == "clock";
+}
+
+static std::vector<std::string>
+get_unique_order(const std::vector<std::string> &order) {
+  std::vector<std::string> unique_order;
+  std::set<std::string> seen;
+  for (const auto &name : order) {
+    if (seen.find(name) == seen.end()) {
+      unique_order.push_back(name);
+      seen.insert(name);
+    }
+  }
+  return unique_order;
+}
+
+bool Layout::update(const Key &new_key, const Config::Config &cfg,
+                    const Config::Style &style, const RenderState &state,
+                    double prompt_width) {
+  if (matches(new_key))
+    return false;
+
+  key = new_key;
+  valid = true;
+  nodes.clear();
+
+  double available_w = key.width - (cfg.window_border_width * 2) -
+                       cfg.window_padding.left - cfg.window_padding.right;
+  double left = cfg.window_border_width + cfg.window_padding.left;
+
+  bool side_preview = cfg.preview_enable &&
+                      style.layout_preview_side != Config::PreviewSide::Bottom;
+  if (!side_preview) {
+    build_column(cfg, style, state, left, available_w, false, prompt_width);
+    return true;
+  }
+
+  bool preview_on_left =
+      style.layout_preview_side == Config::PreviewSide::Left;
+  double preview_w = (available_w * cfg.layout_preview_ratio) / 100.0;
+  double content_w = available_w - preview_w;
+  double preview_x = preview_on_left ? left : left + content_w;
+  double content_x = preview_on_left ? left + preview_w : left;
+
+  if (key.has_results) {
+    double total_available_h = key.height - (cfg.window_border_width * 2) -
+                               cfg.window_padding.top -
+                               cfg.window_padding.bottom;
+    const auto &m = cfg.preview_margin;
+    nodes.push_back(
+        {"preview",
+         BLRect(preview_x + m.left,
+                cfg.window_border_width + cfg.window_padding.top,
+                preview_w - (m.left + m.right),
+                total_available_h - (m.top + m.bottom))});
+  }
+
+  build_column(cfg, style, state, content_x, content_w, true, prompt_width);
+  return true;
+}
+
+void Layout::build_column(const Config::Config &cfg,
+                          const Config::Style &style, const RenderState &state,
+                          double column_x, double column_w, bool skip_preview,
+                          double prompt_width) {
+  double total_available_h = key.height - (cfg.window_border_width * 2) -
+                             cfg.window_padding.top - cfg.window_padding.bottom;
+
+  auto unique_order = get_unique_order(cfg.layout_order);
+  auto skipped = [&](const std::string &name) {
+    return name == "background" || (skip_preview && name == "preview") ||
+           !is_component(name);
+  };
+
+  std::vector<double> heights(unique_order.size(), 0);
+  double fixed_heights = 0;
+  for (size_t i = 0; i < unique_order.size(); ++i) {
+    const auto &name = unique_order[i];
+    if (skipped(name) || name == "results")
+      continue;
+    heights[i] = estimate_component_height(name, cfg, style, state);
+    fixed_heights += heights[i];
+  }
+
+  double results_h = std::max(0.0, total_available_h - fixed_heights);
+  double current_y = cfg.window_border_width + cfg.window_padding.top;
+
+  for (size_t i = 0; i < unique_order.size(); ++i) {
+    const auto &name = unique_order[i];
+    if (skipped(name))
+      continue;
+
+    double comp_h = name == "results" ? results_h : heights[i];
+    if (comp_h <= 0)
+      continue;
+
+    Config::Padding margin = component_margin(name, cfg);
+    current_y += margin.top;
+    double draw_h = comp_h - (margin.top + margin.bottom);
+    double draw_x = column_x + margin.left;
+    double draw_w = column_w - (margin.left + margin.right);
+
+    if (name == "input" && cfg.input_prompt_enable) {
+      const auto &pm = cfg.input_prompt_margin;
+      double prompt_outer_w = prompt_width + pm.left + pm.right;
+      double prompt_comp_h =
+          estimate_component_height("input_prompt", cfg, style, state);
+      double input_width = draw_w - prompt_outer_w;
+      bool prompt_on_left =
+          style.input_prompt_side == Config::PromptSide::Left;
+
+      double prompt_x = prompt_on_left ? draw_x + pm.left
+                                       : draw_x + input_width + pm.left;
+      double prompt_y = (current_y - margin.top) + pm.top;
+      nodes.push_back({"input_prompt",
+                       BLRect(prompt_x, prompt_y, prompt_width,
+                              prompt_comp_h - (pm.top + pm.bottom))});
+
+      double input_x = prompt_on_left ? draw_x + prompt_outer_w : draw_x;
+      nodes.push_back(
+          {"input", BLRect(input_x, current_y, input_width, draw_h)});
+    } else {
+      nodes.push_back({name, BLRect(draw_x, current_y, draw_w, draw_h)});
+    }
+
+    // every component fills exactly the height it was given
+    current_y += draw_h + margin.bottom;
+  }
+}
+
+const BLRect *Layout::find(const std::string &name) const {
+  for (const auto &node : nodes) {
+    if (node.name == name)
+      return &node.rect;
+  }
+  return nullptr;
+}
+
+} // namespace Lawnch::Core::Window::Render
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <blend2d.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../../config/config.hpp"
+#include "../../config/style.hpp"
+#include "render_state.hpp"
+
+namespace Lawnch::Core::Window::Render {
+
+// Where every component sits in the window. Only depends on the config, the
+// surface size and whether the results and the preview are shown, so it is
+// worked out once and reused until one of those changes.
+class Layout {
+public:
+  struct Node {
+    std::string name;
+    BLRect rect;
+  };
+
+  struct Key {
+    uint64_t config_generation = 0;
+    int width = 0;
+    int height = 0;
+    bool has_results = false;
+    double preview_height = 0;
+
+    bool operator==(const Key &other) const = default;
+  };
+
+  // Rebuilds the nodes when `key` differs from the one they were built for,
+  // returns true if it did.
+  bool update(const Key &key, const Config::Config &cfg,
+              const Config::Style &style, const RenderState &state,
+              double prompt_width);
+  bool matches(const Key &other) const { return valid && other == key; }
+  void invalidate() { valid = false; }
+
+  // in drawing order, background excluded
+  const std::vector<Node> &get_nodes() const { return nodes; }
+  const BLRect *find(const std::string &name) const;
+
+private:
+  Key key;
+  bool valid = false;
+  std::vector<Node> nodes;
+
+  void build_column(const Config::Config &cfg, const Config::Style &style,
+                    const RenderState &state, double column_x,
+                    double column_w, bool skip_preview, double prompt_width);
+};
+
+} // namespace Lawnch::Core::Window::Render
@@ -9,10 +9,12 @@
 #include "components/preview.hpp"
 #include "components/results_container.hpp"
 #include "components/results_count.hpp"
+#include "../../config/manager.hpp"
+#include "damage.hpp"
 #include <algorithm>
 #include <cmath>
+#include <cstring>
 #include <iostream>
-#include <set>
 
 namespace Lawnch::Core::Window::Render {
 
@@ -29,400 +31,237 @@ void Renderer::init_components() {
   components["clock"] = std::make_unique<Components::Clock>();
 }
 
-double estimate_component_height(const std::string &name,
-                                 const Config::Config &cfg,
-                                 const RenderState &state) {
-  if (name == "input") {
-    if (!cfg.input_visible)
-      return 0;
-    BLFont font = Lawnch::Gfx::get_font(
-        cfg.input_font_family, cfg.input_font_size, cfg.input_font_weight);
-    BLFontMetrics fm = font.metrics();
-    return fm.ascent + fm.descent + cfg.input_padding.top +
-           cfg.input_padding.bottom + cfg.input_margin.top +
-           cfg.input_margin.bottom;
-  }
-  if (name == "input_prompt" && cfg.input_prompt_enable) {
-    BLFont font = Lawnch::Gfx::get_font(cfg.input_prompt_font_family,
-                                        cfg.input_prompt_font_size,
-                                        cfg.input_prompt_font_weight);
-    BLFontMetrics fm = font.metrics();
-    return fm.ascent + fm.descent + cfg.input_prompt_padding.top +
-           cfg.input_prompt_padding.bottom + cfg.input_prompt_margin.top +
-           cfg.input_prompt_margin.bottom;
-  }
-  if (name == "results_count" && cfg.results_count_enable) {
-    BLFont font = Lawnch::Gfx::get_font(cfg.results_count_font_family,
-                                        cfg.results_count_font_size,
-                                        cfg.results_count_font_weight);
-    BLFontMetrics fm = font.metrics();
-    return fm.ascent + fm.descent + cfg.results_count_padding.top +
-           cfg.results_count_padding.bottom + cfg.results_count_margin.top +
-           cfg.results_count_margin.bottom;
+static bool same_results(const std::vector<Search::SearchResult> &a,
+                         const std::vector<Search::SearchResult> &b) {
+  if (a.size() != b.size())
+    return false;
+  for (size_t i = 0; i < a.size(); ++i) {
+    if (a[i].name != b[i].name || a[i].comment != b[i].comment ||
+        a[i].icon != b[i].icon || a[i].command != b[i].command ||
+        a[i].type != b[i].type ||
+        a[i].preview_image_path != b[i].preview_image_path)
+      return false;
   }
-  if (name == "clock" && cfg.clock_enable) {
-    BLFont font = Lawnch::Gfx::get_font(
-        cfg.clock_font_family, cfg.clock_font_size, cfg.clock_font_weight);
-    BLFontMetrics fm = font.metrics();
-    return fm.ascent + fm.descent + cfg.clock_padding.top +
-           cfg.clock_padding.bottom + cfg.clock_margin.top +
-           cfg.clock_margin.bottom;
-  }
-  if (name == "preview" && cfg.preview_enable && !state.results.empty()) {
-    return Components::Preview::get_height(cfg, state) +
-           cfg.preview_margin.top + cfg.preview_margin.bottom;
-  }
-  return 0;
+  return true;
 }
 
-std::vector<std::string>
-get_unique_order(const std::vector<std::string> &order) {
-  std::vector<std::string> unique_order;
-  std::set<std::string> seen;
-  for (const auto &name : order) {
-    if (seen.find(name) == seen.end()) {
-      unique_order.push_back(name);
-      seen.insert(name);
-    }
-  }
-  return unique_order;
+void Renderer::invalidate_component(const std::string &name) {
+  dirty_components.push_back(name);
 }
 
-void Renderer::render(BLContext &ctx, int width, int height,
-                      const Config::Config &cfg, const RenderState &state) {
-  if (!cached_metrics.valid)
-    update_metrics(cfg);
+std::vector<BLRectI> Renderer::compute_damage(int width, int height,
+                                              const Config::Config &cfg,
+                                              const RenderState &state) const {
+  std::vector<BLRectI> full{BLRectI(0, 0, width, height)};
 
-  if (components.count("background")) {
-    ComponentContext bg_ctx{ctx,
-                            width,
-                            height,
-                            cfg,
-                            state,
-                            0,
-                            0,
-                            static_cast<double>(width),
-                            static_cast<double>(height)};
-    components["background"]->draw(bg_ctx);
+  // anything that can move components around repaints everything
+  if (full_redraw || width != last.width || height != last.height ||
+      !same_results(state.results, last.results) ||
+      !layout.matches(layout_key(width, height, cfg, state))) {
+    return full;
   }
 
-  bool use_side_preview =
-      cfg.preview_enable && (cfg.layout_preview_side == "left" ||
-                             cfg.layout_preview_side == "right");
-
-  if (use_side_preview && cfg.layout_preview_side == "left") {
-    render_with_side_preview(ctx, width, height, cfg, state, true);
-  } else if (use_side_preview && cfg.layout_preview_side == "right") {
-    render_with_side_preview(ctx, width, height, cfg, state, false);
-  } else {
-    render_vertical(ctx, width, height, cfg, state);
+  std::vector<BLRectI> damage;
+  auto add_rect = [&](const BLRect &rect) {
+    damage.push_back(Damage::to_device(rect, width, height));
+  };
+  auto add_component = [&](const std::string &name) {
+    if (const BLRect *rect = layout.find(name))
+      add_rect(*rect);
+  };
+
+  bool text_changed = state.search_text != last.search_text;
+  if (text_changed || state.caret_position != last.caret_position ||
+      state.input_selected != last.input_selected) {
+    add_component("input");
   }
-}
 
-void Renderer::render_vertical(BLContext &ctx, int width, int height,
-                               const Config::Config &cfg,
-                               const RenderState &state) {
-  double available_w = width - (cfg.window_border_width * 2) -
-                       cfg.window_padding.left - cfg.window_padding.right;
-  double x = cfg.window_border_width + cfg.window_padding.left;
-  double total_available_h = height - (cfg.window_border_width * 2) -
-                             cfg.window_padding.top - cfg.window_padding.bottom;
-
-  auto unique_order = get_unique_order(cfg.layout_order);
-
-  double fixed_heights = 0;
-  for (const auto &comp_name : unique_order) {
-    if (comp_name == "background")
-      continue;
-    if (comp_name == "results")
-      continue;
-    fixed_heights += estimate_component_height(comp_name, cfg, state);
+  if (text_changed || state.scroll_offset != last.scroll_offset) {
+    // match highlighting follows the text, scrolling moves every row
+    add_component("results");
+    add_component("preview");
+  } else if (state.selected_index != last.selected_index) {
+    auto *results = static_cast<const Components::ResultsContainer *>(
+        components.at("results").get());
+    for (int index : {last.selected_index, state.selected_index}) {
+      if (const BLRect *row = results->get_row_rect(index))
+        add_rect(*row);
+    }
+    add_component("preview");
   }
 
-  double results_h = total_available_h - fixed_heights;
-  if (results_h < 0)
-    results_h = 0;
-
-  double current_y = cfg.window_border_width + cfg.window_padding.top;
+  if (cfg.clock_enable &&
+      Components::Clock::format_time(cfg) != last.clock_text) {
+    add_component("clock");
+  }
 
-  for (const auto &comp_name : unique_order) {
-    if (comp_name == "background")
-      continue;
+  for (const auto &name : dirty_components) {
+    add_component(name);
+  }
 
-    auto it = components.find(comp_name);
-    if (it == components.end())
-      continue;
+  Damage::merge(damage);
+  return damage;
+}
 
-    double comp_h;
-    if (comp_name == "results") {
-      comp_h = results_h;
-    } else {
-      comp_h = estimate_component_height(comp_name, cfg, state);
-    }
+std::optional<std::vector<BLRectI>>
+Renderer::scroll_blit(BLImage &target, const BLImage *previous,
+                      const std::vector<BLRectI> &stale,
+                      const Config::Config &cfg, const RenderState &state) {
+  int width = last.width;
+  int height = last.height;
+  if (full_redraw || !previous || state.scroll_offset == last.scroll_offset ||
+      state.search_text != last.search_text ||
+      state.caret_position != last.caret_position ||
+      state.input_selected != last.input_selected ||
+      !same_results(state.results, last.results) ||
+      !layout.matches(layout_key(width, height, cfg, state))) {
+    return std::nullopt;
+  }
 
-    if (comp_h <= 0)
-      continue;
-
-    // Apply margins
-    double margin_top = 0;
-    double margin_bottom = 0;
-    double margin_left = 0;
-    double margin_right = 0;
-
-    if (comp_name == "input") {
-      margin_top = cfg.input_margin.top;
-      margin_bottom = cfg.input_margin.bottom;
-      margin_left = cfg.input_margin.left;
-      margin_right = cfg.input_margin.right;
-    } else if (comp_name == "clock") {
-      margin_top = cfg.clock_margin.top;
-      margin_bottom = cfg.clock_margin.bottom;
-      margin_left = cfg.clock_margin.left;
-      margin_right = cfg.clock_margin.right;
-    } else if (comp_name == "results_count") {
-      margin_top = cfg.results_count_margin.top;
-      margin_bottom = cfg.results_count_margin.bottom;
-      margin_left = cfg.results_count_margin.left;
-      margin_right = cfg.results_count_margin.right;
-    } else if (comp_name == "preview") {
-      margin_top = cfg.preview_margin.top;
-      margin_bottom = cfg.preview_margin.bottom;
-      margin_left = cfg.preview_margin.left;
-      margin_right = cfg.preview_margin.right;
-    }
+  BLImageData dst, src;
+  if (target.get_data(&dst) != BL_SUCCESS ||
+      previous->get_data(&src) != BL_SUCCESS || dst.size.w != width ||
+      dst.size.h != height || src.size.w != width || src.size.h != height) {
+    return std::nullopt;
+  }
 
-    current_y += margin_top;
-    double draw_h = comp_h - (margin_top + margin_bottom);
-    double draw_x = x + margin_left;
-    double draw_w = available_w - (margin_left + margin_right);
-
-    if (comp_name == "input") {
-      if (!cfg.input_visible)
-        continue;
-      auto input_comp = it->second.get();
-      auto prompt_comp_it = components.find("input_prompt");
-      auto prompt_comp =
-          dynamic_cast<Components::InputPrompt *>(prompt_comp_it->second.get());
-
-      if (prompt_comp && cfg.input_prompt_enable) {
-        double prompt_margin_left = cfg.input_prompt_margin.left;
-        double prompt_margin_right = cfg.input_prompt_margin.right;
-        double prompt_margin_top = cfg.input_prompt_margin.top;
-        double prompt_margin_bottom = cfg.input_prompt_margin.bottom;
-
-        double prompt_width = prompt_comp->calculate_width(cfg) +
-                              prompt_margin_left + prompt_margin_right;
-        double prompt_comp_h =
-            estimate_component_height("input_prompt", cfg, state);
-
-        double input_width = draw_w - prompt_width;
-        bool prompt_on_left = cfg.input_prompt_side != "right";
-
-        // Prompt Draw Props
-        double prompt_draw_x = prompt_on_left
-                                   ? draw_x + prompt_margin_left
-                                   : draw_x + input_width + prompt_margin_left;
-        double prompt_draw_y = current_y + prompt_margin_top - margin_top;
-        prompt_draw_y = current_y + prompt_margin_top - margin_top;
-        prompt_draw_y = (current_y - margin_top) + prompt_margin_top;
-
-        double prompt_draw_h =
-            prompt_comp_h - (prompt_margin_top + prompt_margin_bottom);
-        double prompt_draw_w =
-            prompt_width - (prompt_margin_left + prompt_margin_right);
-
-        // Input
-        double input_draw_x = prompt_on_left ? draw_x + prompt_width : draw_x;
-
-        ComponentContext prompt_ctx{
-            ctx,           width,         height,        cfg,          state,
-            prompt_draw_x, prompt_draw_y, prompt_draw_w, prompt_draw_h};
-        prompt_comp->draw(prompt_ctx);
-
-        ComponentContext input_ctx{ctx,       width,       height,
-                                   cfg,       state,       input_draw_x,
-                                   current_y, input_width, draw_h};
-        auto result = input_comp->draw(input_ctx);
-        current_y += draw_h + margin_bottom;
-      } else {
-        ComponentContext comp_ctx{ctx,    width,     height, cfg,   state,
-                                  draw_x, current_y, draw_w, draw_h};
-        auto result = it->second->draw(comp_ctx);
-        current_y += result.used_height + margin_bottom;
+  // catch the target up with the last frame, then scroll it in place
+  if (dst.pixel_data != src.pixel_data) {
+    for (const auto &rect : stale) {
+      for (int y = rect.y; y < rect.y + rect.h; ++y) {
+        auto *to = static_cast<uint8_t *>(dst.pixel_data) + y * dst.stride;
+        auto *from =
+            static_cast<const uint8_t *>(src.pixel_data) + y * src.stride;
+        std::memcpy(to + rect.x * 4, from + rect.x * 4, (size_t)rect.w * 4);
       }
-    } else {
-      ComponentContext comp_ctx{ctx,    width,     height, cfg,   state,
-                                draw_x, current_y, draw_w, draw_h};
-      auto result = it->second->draw(comp_ctx);
-      current_y += result.used_height + margin_bottom;
     }
   }
-}
 
-void Renderer::render_with_side_preview(BLContext &ctx, int width, int height,
-                                        const Config::Config &cfg,
-                                        const RenderState &state,
-                                        bool preview_on_left) {
-  double available_w = width - (cfg.window_border_width * 2) -
-                       cfg.window_padding.left - cfg.window_padding.right;
-  double preview_w = (available_w * cfg.layout_preview_ratio) / 100.0;
-  double content_w = available_w - preview_w;
-
-  double preview_x =
-      preview_on_left
-          ? cfg.window_border_width + cfg.window_padding.left
-          : cfg.window_border_width + cfg.window_padding.left + content_w;
-  double content_x =
-      preview_on_left
-          ? cfg.window_border_width + cfg.window_padding.left + preview_w
-          : cfg.window_border_width + cfg.window_padding.left;
-
-  double total_available_h = height - (cfg.window_border_width * 2) -
-                             cfg.window_padding.top - cfg.window_padding.bottom;
-
-  if (cfg.preview_enable && !state.results.empty()) {
-    auto it = components.find("preview");
-    if (it != components.end()) {
-      double p_margin_left = cfg.preview_margin.left;
-      double p_margin_right = cfg.preview_margin.right;
-      double p_margin_top = cfg.preview_margin.top;
-      double p_margin_bottom = cfg.preview_margin.bottom;
-
-      double p_draw_x = preview_x + p_margin_left;
-      double p_draw_w = preview_w - (p_margin_left + p_margin_right);
-      double p_draw_y =
-          cfg.window_border_width + cfg.window_padding.top + p_margin_top;
-      double p_draw_h = total_available_h - (p_margin_top + p_margin_bottom);
-
-      ComponentContext preview_ctx{
-          ctx,
-          width,
-          height,
-          cfg,
-          state,
-          p_draw_x,
-          static_cast<double>(cfg.window_border_width + cfg.window_padding.top),
-          p_draw_w,
-          p_draw_h};
-      it->second->draw(preview_ctx);
-    }
+  auto *results = static_cast<Components::ResultsContainer *>(
+      components.at("results").get());
+  auto rows = results->scroll_rows(dst, dst, state, last.selected_index);
+  if (!rows) {
+    // the target now holds the last frame everywhere it was stale, but the
+    // caller repaints all of that anyway
+    return std::nullopt;
   }
 
-  auto unique_order = get_unique_order(cfg.layout_order);
-  double fixed_heights = 0;
-  for (const auto &comp_name : unique_order) {
-    if (comp_name == "background" || comp_name == "preview" ||
-        comp_name == "results")
-      continue;
-    fixed_heights += estimate_component_height(comp_name, cfg, state);
+  std::vector<BLRectI> repaint;
+  auto add_component = [&](const std::string &name) {
+    if (const BLRect *rect = layout.find(name))
+      repaint.push_back(Damage::to_device(*rect, width, height));
+  };
+
+  for (const auto &row : *rows) {
+    repaint.push_back(Damage::to_device(row, width, height));
+  }
+  if (state.selected_index != last.selected_index)
+    add_component("preview");
+  if (cfg.clock_enable &&
+      Components::Clock::format_time(cfg) != last.clock_text) {
+    add_component("clock");
+  }
+  for (const auto &name : dirty_components) {
+    add_component(name);
   }
 
-  double results_h = total_available_h - fixed_heights;
-  if (results_h < 0)
-    results_h = 0;
+  Damage::merge(repaint);
+  return repaint;
+}
 
-  double current_y = cfg.window_border_width + cfg.window_padding.top;
+void Renderer::update_snapshot(int width, int height,
+                               const Config::Config &cfg,
+                               const RenderState &state) {
+  last.width = width;
+  last.height = height;
+  last.search_text = state.search_text;
+  last.caret_position = state.caret_position;
+  last.input_selected = state.input_selected;
+  last.results = state.results;
+  last.selected_index = state.selected_index;
+  last.scroll_offset = state.scroll_offset;
+  last.clock_text =
+      cfg.clock_enable ? Components::Clock::format_time(cfg) : "";
+  full_redraw = false;
+  dirty_components.clear();
+}
 
-  for (const auto &comp_name : unique_order) {
-    if (comp_name == "background" || comp_name == "preview")
-      continue;
+void Renderer::draw_component(const Layout::Node &node, BLContext &ctx,
+                              int width, int height, const Config::Config &cfg,
+                              const Config::Style &style,
+                              const RenderState &state) {
+  // untouched by this pass
+  if (!Damage::intersects(node.rect, current_damage))
+    return;
+
+  auto it = components.find(node.name);
+  if (it == components.end())
+    return;
+
+  ComponentContext comp_ctx{ctx,         width,       height,
+                            cfg,         style,       state,
+                            node.rect.x, node.rect.y, node.rect.w,
+                            node.rect.h};
+  comp_ctx.damage = current_damage;
+  it->second->draw(comp_ctx);
+}
 
-    auto it = components.find(comp_name);
-    if (it == components.end())
-      continue;
+Layout::Key Renderer::layout_key(int width, int height,
+                                 const Config::Config &cfg,
+                                 const RenderState &state) const {
+  Layout::Key key;
+  key.config_generation = Config::Manager::Instance().Generation();
+  key.width = width;
+  key.height = height;
+  key.has_results = !state.results.empty();
+  key.preview_height = Components::Preview::get_height(
+      cfg, Config::Manager::Instance().GetStyle(), state);
+  return key;
+}
 
-    double comp_h;
-    if (comp_name == "results") {
-      comp_h = results_h;
-    } else {
-      comp_h = estimate_component_height(comp_name, cfg, state);
-    }
+void Renderer::render(BLContext &ctx, int width, int height,
+                      const Config::Config &cfg, const RenderState &state,
+                      const std::vector<BLRectI> &damage) {
+  if (!cached_metrics.valid)
+    update_metrics(cfg);
 
-    if (comp_h <= 0)
-      continue;
-
-    double margin_top = 0;
-    double margin_bottom = 0;
-    double margin_left = 0;
-    double margin_right = 0;
-
-    if (comp_name == "input") {
-      margin_top = cfg.input_margin.top;
-      margin_bottom = cfg.input_margin.bottom;
-      margin_left = cfg.input_margin.left;
-      margin_right = cfg.input_margin.right;
-    } else if (comp_name == "clock") {
-      margin_top = cfg.clock_margin.top;
-      margin_bottom = cfg.clock_margin.bottom;
-      margin_left = cfg.clock_margin.left;
-      margin_right = cfg.clock_margin.right;
-    } else if (comp_name == "results_count") {
-      margin_top = cfg.results_count_margin.top;
-      margin_bottom = cfg.results_count_margin.bottom;
-      margin_left = cfg.results_count_margin.left;
-      margin_right = cfg.results_count_margin.right;
+  // icons asked for during this pass are the ones on screen
+  Icons::Manager::Instance().begin_frame();
+
+  const auto &style = Config::Manager::Instance().GetStyle();
+  auto *prompt = static_cast<Components::InputPrompt *>(
+      components.at("input_prompt").get());
+  layout.update(layout_key(width, height, cfg, state), cfg, style, state,
+                prompt->calculate_width(cfg, style));
+
+  for (const auto &rect : damage) {
+    current_damage = BLRect(rect.x, rect.y, rect.w, rect.h);
+    ctx.save();
+    ctx.clip_to_rect(current_damage);
+
+    if (components.count("background")) {
+      ComponentContext bg_ctx{ctx,
+                              width,
+                              height,
+                              cfg,
+                              style,
+                              state,
+                              0,
+                              0,
+                              static_cast<double>(width),
+                              static_cast<double>(height)};
+      components["background"]->draw(bg_ctx);
     }
 
-    current_y += margin_top;
-    double draw_h = comp_h - (margin_top + margin_bottom);
-    double draw_x = content_x + margin_left;
-    double draw_w = content_w - (margin_left + margin_right);
-
-    if (comp_name == "input") {
-      auto input_comp = it->second.get();
-      auto prompt_comp_it = components.find("input_prompt");
-      auto prompt_comp =
-          dynamic_cast<Components::InputPrompt *>(prompt_comp_it->second.get());
-
-      if (prompt_comp && cfg.input_prompt_enable) {
-        double prompt_margin_left = cfg.input_prompt_margin.left;
-        double prompt_margin_right = cfg.input_prompt_margin.right;
-        double prompt_margin_top = cfg.input_prompt_margin.top;
-        double prompt_margin_bottom = cfg.input_prompt_margin.bottom;
-
-        double prompt_width = prompt_comp->calculate_width(cfg) +
-                              prompt_margin_left + prompt_margin_right;
-        double prompt_comp_h =
-            estimate_component_height("input_prompt", cfg, state);
-
-        double input_width = draw_w - prompt_width;
-        bool prompt_on_left = cfg.input_prompt_side != "right";
-
-        double prompt_draw_y = (current_y - margin_top) + prompt_margin_top;
-        double prompt_draw_h =
-            prompt_comp_h - (prompt_margin_top + prompt_margin_bottom);
-        double prompt_draw_w =
-            prompt_width - (prompt_margin_left + prompt_margin_right);
-
-        double prompt_draw_x = prompt_on_left
-                                   ? draw_x + prompt_margin_left
-                                   : draw_x + input_width + prompt_margin_left;
-
-        double input_draw_x = prompt_on_left ? draw_x + prompt_width : draw_x;
-
-        ComponentContext prompt_ctx{
-            ctx,           width,         height,        cfg,          state,
-            prompt_draw_x, prompt_draw_y, prompt_draw_w, prompt_draw_h};
-        prompt_comp->draw(prompt_ctx);
-
-        ComponentContext input_ctx{ctx,       width,       height,
-                                   cfg,       state,       input_draw_x,
-                                   current_y, input_width, draw_h};
-        auto result = input_comp->draw(input_ctx);
-        current_y += draw_h + margin_bottom;
-      } else {
-        ComponentContext comp_ctx{ctx,    width,     height, cfg,   state,
-                                  draw_x, current_y, draw_w, draw_h};
-        auto result = it->second->draw(comp_ctx);
-        current_y += result.used_height + margin_bottom;
-      }
-    } else {
-      ComponentContext comp_ctx{ctx,    width,     height, cfg,   state,
-                                draw_x, current_y, draw_w, draw_h};
-      auto result = it->second->draw(comp_ctx);
-      current_y += result.used_height + margin_bottom;
+    for (const auto &node : layout.get_nodes()) {
+      draw_component(node, ctx, width, height, cfg, style, state);
     }
+
+    ctx.restore();
   }
+  current_damage = BLRect();
+
+  update_snapshot(width, height, cfg, state);
 }
 
 int Renderer::get_visible_count(int height, const Config::Config &cfg) {
@@ -441,7 +280,9 @@ int Renderer::get_visible_count(int height, const Config::Config &cfg) {
   }
 
   double preview_h = 0;
-  if (cfg.preview_enable && cfg.layout_preview_side == "bottom") {
+  const auto &style = Config::Manager::Instance().GetStyle();
+  if (cfg.preview_enable &&
+      style.layout_preview_side == Config::PreviewSide::Bottom) {
     preview_h = cfg.preview_icon_size + cfg.preview_padding.top +
                 cfg.preview_padding.bottom;
   }
@@ -463,20 +304,12 @@ int Renderer::get_visible_count(int height, const Config::Config &cfg) {
 }
 
 void Renderer::update_metrics(const Config::Config &cfg) {
-  BLFont font = Lawnch::Gfx::get_font(cfg.result_item_font_family,
-                                      cfg.result_item_font_size,
-                                      cfg.result_item_font_weight);
-  BLFontMetrics metrics = font.metrics();
-  double name_h = metrics.ascent + metrics.descent;
+  const auto &style = Config::Manager::Instance().GetStyle();
+  double name_h = style.result_item_font.height;
 
   double comment_h = 0;
-  if (cfg.result_item_comment_enable) {
-    BLFont cfont = Lawnch::Gfx::get_font(cfg.result_item_font_family,
-                                         cfg.result_item_comment_font_size,
-                                         cfg.result_item_comment_font_weight);
-    BLFontMetrics cmetrics = cfont.metrics();
-    comment_h = cmetrics.ascent + cmetrics.descent;
-  }
+  if (cfg.result_item_comment_enable)
+    comment_h = style.result_item_comment_font.height;
 
   double text_gap = 4.0;
   double item_inner_h = name_h;
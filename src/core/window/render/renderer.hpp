@@ -3,11 +3,13 @@
 #include <blend2d.h>
 #include <map>
 #include <memory>
+#include <optional>
 #include <string>
 #include <vector>
 
 #include "../../config/config.hpp"
 #include "components/component_base.hpp"
+#include "layout.hpp"
 #include "render_state.hpp"
 
 namespace Lawnch::Core::Window::Render {
@@ -17,10 +19,31 @@ public:
   Renderer();
   ~Renderer();
 
+  // Areas that differ between the last rendered frame and this state, empty
+  // when nothing changed.
+  std::vector<BLRectI> compute_damage(int width, int height,
+                                      const Config::Config &cfg,
+                                      const RenderState &state) const;
+  // Repaints only the given areas, each clipped to itself.
   void render(BLContext &ctx, int width, int height, const Config::Config &cfg,
-              const RenderState &state);
+              const RenderState &state, const std::vector<BLRectI> &damage);
   int get_visible_count(int height, const Config::Config &cfg);
 
+  // Fast path for frames that only scroll the results: brings `target` up to
+  // date from `previous` (the last presented frame) over `stale`, shifts the
+  // rows still on screen and returns the smaller set of areas render() has
+  // to draw. nullopt when anything else changed.
+  std::optional<std::vector<BLRectI>>
+  scroll_blit(BLImage &target, const BLImage *previous,
+              const std::vector<BLRectI> &stale, const Config::Config &cfg,
+              const RenderState &state);
+
+  void invalidate() {
+    full_redraw = true;
+    layout.invalidate();
+  }
+  void invalidate_component(const std::string &name);
+
 private:
   struct Metrics {
     double item_height = 0;
@@ -29,13 +52,34 @@ private:
 
   std::map<std::string, std::unique_ptr<ComponentBase>> components;
 
+  // what the last frame was drawn from
+  struct Snapshot {
+    int width = 0;
+    int height = 0;
+    std::string search_text;
+    int caret_position = 0;
+    bool input_selected = false;
+    std::vector<Search::SearchResult> results;
+    int selected_index = 0;
+    int scroll_offset = 0;
+    std::string clock_text;
+  } last;
+  bool full_redraw = true;
+  std::vector<std::string> dirty_components;
+
+  Layout layout;
+  BLRect current_damage{};
+
+  Layout::Key layout_key(int width, int height, const Config::Config &cfg,
+                         const RenderState &state) const;
+  void draw_component(const Layout::Node &node, BLContext &ctx, int width,
+                      int height, const Config::Config &cfg,
+                      const Config::Style &style, const RenderState &state);
+  void update_snapshot(int width, int height, const Config::Config &cfg,
+                       const RenderState &state);
+
   void init_components();
   void update_metrics(const Config::Config &cfg);
-  void render_vertical(BLContext &ctx, int width, int height,
-                       const Config::Config &cfg, const RenderState &state);
-  void render_with_side_preview(BLContext &ctx, int width, int height,
-                                const Config::Config &cfg,
-                                const RenderState &state, bool preview_on_left);
 };
 
 } // namespace Lawnch::Core::Window::Render
@@ -9,6 +9,10 @@ static const struct zwlr_layer_surface_v1_listener layer_surface_listener = {
     .closed = LayerSurface::closed_handler,
 };
 
+static const struct wl_callback_listener frame_listener = {
+    .done = LayerSurface::frame_done_handler,
+};
+
 LayerSurface::LayerSurface(struct wl_compositor *c,
                            struct zwlr_layer_shell_v1 *shell,
                            struct wl_output *o) {
@@ -22,6 +26,10 @@ LayerSurface::LayerSurface(struct wl_compositor *c,
 LayerSurface::~LayerSurface() { close(); }
 
 void LayerSurface::close() {
+  if (frame_callback) {
+    wl_callback_destroy(frame_callback);
+    frame_callback = nullptr;
+  }
   if (layer_surface) {
     zwlr_layer_surface_v1_destroy(layer_surface);
     layer_surface = nullptr;
@@ -96,14 +104,34 @@ void LayerSurface::apply_config(const Config::Config &cfg) {
   wl_surface_commit(surface);
 }
 
-void LayerSurface::commit(struct wl_buffer *buffer) {
+void LayerSurface::commit(struct wl_buffer *buffer,
+                          const std::vector<DamageRect> &damage) {
   if (surface && buffer) {
     wl_surface_attach(surface, buffer, 0, 0);
-    wl_surface_damage_buffer(surface, 0, 0, INT32_MAX, INT32_MAX);
+    for (const auto &rect : damage) {
+      wl_surface_damage_buffer(surface, rect.x, rect.y, rect.width,
+                               rect.height);
+    }
+    request_frame();
     wl_surface_commit(surface);
   }
 }
 
+void LayerSurface::request_frame() {
+  if (frame_callback)
+    wl_callback_destroy(frame_callback);
+  frame_callback = wl_surface_frame(surface);
+  wl_callback_add_listener(frame_callback, &frame_listener, this);
+}
+
+void LayerSurface::frame_done_handler(void *data, struct wl_callback *cb,
+                                      uint32_t) {
+  auto self = static_cast<LayerSurface *>(data);
+  wl_callback_destroy(cb);
+  if (self->frame_callback == cb)
+    self->frame_callback = nullptr;
+}
+
 void LayerSurface::configure_handler(void *data,
                                      struct zwlr_layer_surface_v1 *ls,
                                      uint32_t serial, uint32_t w, uint32_t h) {
@@ -2,6 +2,7 @@
 
 #include "../../config/config.hpp"
 #include <functional>
+#include <vector>
 #include <wayland-client.h>
 
 extern "C" {
@@ -14,6 +15,13 @@ namespace Lawnch::Core::Window::Wayland {
 
 class LayerSurface {
 public:
+  struct DamageRect {
+    int x;
+    int y;
+    int width;
+    int height;
+  };
+
   LayerSurface(struct wl_compositor *compositor,
                struct zwlr_layer_shell_v1 *shell, struct wl_output *output);
   ~LayerSurface();
@@ -25,8 +33,10 @@ public:
   int get_height() const { return height; }
 
   bool is_configured() const { return width > 0 && height > 0; }
+  // a frame callback from the last commit has not fired yet
+  bool is_frame_pending() const { return frame_callback != nullptr; }
 
-  void commit(struct wl_buffer *buffer);
+  void commit(struct wl_buffer *buffer, const std::vector<DamageRect> &damage);
   void close();
 
   std::function<void(int w, int h)> on_configure;
@@ -35,10 +45,15 @@ public:
   static void configure_handler(void *data, struct zwlr_layer_surface_v1 *ls,
                                 uint32_t serial, uint32_t w, uint32_t h);
   static void closed_handler(void *data, struct zwlr_layer_surface_v1 *ls);
+  static void frame_done_handler(void *data, struct wl_callback *cb,
+                                 uint32_t time);
 
 private:
   struct wl_surface *surface = nullptr;
   struct zwlr_layer_surface_v1 *layer_surface = nullptr;
+  struct wl_callback *frame_callback = nullptr;
+
+  void request_frame();
 
   int width = 0;
   int height = 0;
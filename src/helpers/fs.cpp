@@ -129,4 +129,31 @@ std::string make_temp_dir(const std::string &prefix) {
   return tmpl;
 }
 
+bool write_file_atomic(const std::filesystem::path &path,
+                       std::string_view data) {
+  std::string tmp_path =
+      (path.parent_path() / (path.filename().string() + "-XXXXXX")).string();
+  int fd = mkstemp(tmp_path.data());
+  if (fd < 0)
+    return false;
+
+  size_t written = 0;
+  while (written < data.size()) {
+    ssize_t n = ::write(fd, data.data() + written, data.size() - written);
+    if (n <= 0)
+      break;
+    written += n;
+  }
+  bool ok = ::close(fd) == 0 && written == data.size();
+
+  std::error_code ec;
+  if (ok)
+    std::filesystem::rename(tmp_path, path, ec);
+  if (!ok || ec) {
+    std::filesystem::remove(tmp_path, ec);
+    return false;
+  }
+  return true;
+}
+
 } // namespace Lawnch::Fs
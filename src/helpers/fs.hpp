@@ -1,6 +1,7 @@
 #pragma once
 #include <filesystem>
 #include <string>
+#include <string_view>
 #include <vector>
 
 namespace Lawnch::Fs {
@@ -20,4 +21,10 @@ std::vector<std::string> get_icon_dirs();
 
 std::string make_temp_dir(const std::string &prefix);
 
+// Writes `data` to a mkstemp file next to `path` and renames it over
+// `path`, so readers see the old file or the new one, never half of it.
+// False if anything failed, the temporary file is gone then.
+bool write_file_atomic(const std::filesystem::path &path,
+                       std::string_view data);
+
 } // namespace Lawnch::Fs
@@ -4,12 +4,18 @@
 #include <cmath>
 #include <cstring>
 #include <iostream>
+#include <list>
 #include <map>
 #include <mutex>
 #include <string>
+#include <unordered_map>
 #ifdef __linux__
 #include <fontconfig/fontconfig.h>
 #endif
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define LAWNCH_GFX_X86 1
+#endif
 
 namespace Lawnch::Gfx {
 
@@ -150,56 +156,408 @@ BLFont get_font(const std::string &family, double size,
   return font;
 }
 
-std::string truncate_text(const std::string &text, BLFont &font,
-                          double max_width) {
-  if (text.empty())
-    return "";
+size_t TextRun::fit(double max_width) const {
+  // first glyph that ends past max_width, everything before it fits
+  auto it = std::upper_bound(advances.begin(), advances.end(), max_width);
+  size_t glyph = it - advances.begin();
+  if (glyph >= clusters.size())
+    return SIZE_MAX;
+  return clusters[glyph];
+}
+
+double TextRun::advance_at(size_t byte_offset) const {
+  auto it = std::lower_bound(clusters.begin(), clusters.end(),
+                             (uint32_t)std::min<size_t>(byte_offset,
+                                                        UINT32_MAX));
+  size_t glyph = it - clusters.begin();
+  if (glyph == 0)
+    return 0;
+  return advances[glyph - 1];
+}
+
+BLGlyphRun TextRun::slice(size_t first, size_t count) const {
+  BLGlyphRun run = glyphs.glyph_run();
+  first = std::min(first, run.size);
+  count = std::min(count, run.size - first);
+  run.glyph_data =
+      static_cast<uint8_t *>(run.glyph_data) + first * run.glyph_advance;
+  if (run.placement_data) {
+    run.placement_data = static_cast<uint8_t *>(run.placement_data) +
+                         first * run.placement_advance;
+  }
+  run.size = count;
+  return run;
+}
+
+namespace {
+
+constexpr size_t TEXT_CACHE_MAX = 1024;
+
+struct TextCache {
+  std::mutex mutex;
+  std::list<std::string> order; // most recently used first
+  std::unordered_map<std::string,
+                     std::pair<std::shared_ptr<const TextRun>,
+                               std::list<std::string>::iterator>>
+      runs;
+};
+
+TextCache &text_cache() {
+  static TextCache cache;
+  return cache;
+}
+
+std::string text_cache_key(const BLFont &font, const std::string &text) {
+  std::string key = std::to_string(font.face().unique_id());
+  key += '/';
+  key += std::to_string(font.size());
+  key += '\0';
+  key += text;
+  return key;
+}
+
+} // namespace
 
+std::shared_ptr<const TextRun> shape_text(const BLFont &font,
+                                          const std::string &text) {
+  auto &cache = text_cache();
+  std::string key = text_cache_key(font, text);
+
+  {
+    std::lock_guard<std::mutex> lock(cache.mutex);
+    auto it = cache.runs.find(key);
+    if (it != cache.runs.end()) {
+      cache.order.splice(cache.order.begin(), cache.order, it->second.second);
+      return it->second.first;
+    }
+  }
+
+  auto run = std::make_shared<TextRun>();
+  run->glyphs.set_utf8_text(text.c_str(), text.size());
+  font.shape(run->glyphs);
   BLTextMetrics tm;
-  BLGlyphBuffer gb;
-  gb.set_utf8_text(text.c_str());
-  font.shape(gb);
-  font.get_text_metrics(gb, tm);
+  font.get_text_metrics(run->glyphs, tm);
+  run->width = tm.advance.x;
+
+  // placements are in font units, scale them so they add up to the width
+  size_t count = run->glyphs.size();
+  const BLGlyphPlacement *placements = run->glyphs.placement_data();
+  const BLGlyphInfo *infos = run->glyphs.info_data();
+  double total = 0;
+  for (size_t i = 0; i < count; ++i) {
+    total += placements[i].advance.x;
+  }
+  double scale = total != 0 ? run->width / total : 0;
+
+  run->advances.reserve(count);
+  run->offsets.reserve(count);
+  run->clusters.reserve(count);
+  double pen = 0;
+  for (size_t i = 0; i < count; ++i) {
+    pen += placements[i].advance.x * scale;
+    run->advances.push_back(pen);
+    // font units point up, the surface points down
+    run->offsets.emplace_back(placements[i].placement.x * scale,
+                              -placements[i].placement.y * scale);
+    run->clusters.push_back(infos[i].cluster);
+  }
 
-  if (tm.advance.x <= max_width) {
-    return text;
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  auto it = cache.runs.find(key);
+  if (it != cache.runs.end())
+    return it->second.first;
+  if (cache.runs.size() >= TEXT_CACHE_MAX) {
+    cache.runs.erase(cache.order.back());
+    cache.order.pop_back();
   }
+  cache.order.push_front(key);
+  cache.runs.emplace(std::move(key),
+                     std::make_pair(run, cache.order.begin()));
+  return run;
+}
 
-  std::string ellipsis = "...";
-  BLGlyphBuffer gb_ellipsis;
-  gb_ellipsis.set_utf8_text(ellipsis.c_str());
-  font.shape(gb_ellipsis);
-  BLTextMetrics tm_ellipsis;
-  font.get_text_metrics(gb_ellipsis, tm_ellipsis);
-  double ellipsis_width = tm_ellipsis.advance.x;
+namespace {
+
+// horizontal positions a glyph is rasterized at within one pixel
+constexpr int GLYPH_SUBPIXEL_STEPS = 4;
+constexpr int GLYPH_ATLAS_WIDTH = 1024;
+constexpr int GLYPH_ATLAS_MAX_HEIGHT = 2048;
+
+struct GlyphSlot {
+  BLRectI area{}; // in the atlas, empty for blank glyphs
+  int left = 0;   // mask origin relative to the pen, in whole pixels
+  int top = 0;
+  bool fits = true;
+};
+
+// Every glyph of one face at one size, packed into shelves of an A8 image.
+struct GlyphAtlas {
+  BLImage image;
+  int shelf_x = 0;
+  int shelf_y = 0;
+  int shelf_h = 0;
+  std::unordered_map<uint64_t, GlyphSlot> glyphs;
+
+  void reset(int height) {
+    image.create(GLYPH_ATLAS_WIDTH, height, BL_FORMAT_A8);
+    BLContext ctx(image);
+    ctx.clear_all();
+    ctx.end();
+    shelf_x = shelf_y = shelf_h = 0;
+    glyphs.clear();
+  }
 
-  if (ellipsis_width >= max_width) {
-    return "...";
+  // Finds room for a w x h mask, growing the image or starting over when it
+  // is full.
+  bool allocate(int w, int h, BLPointI &at) {
+    if (w > GLYPH_ATLAS_WIDTH || h > GLYPH_ATLAS_MAX_HEIGHT)
+      return false;
+    if (shelf_x + w > GLYPH_ATLAS_WIDTH) {
+      shelf_y += shelf_h;
+      shelf_x = shelf_h = 0;
+    }
+    if (shelf_y + h > image.height()) {
+      int height = image.height();
+      while (height < shelf_y + h && height < GLYPH_ATLAS_MAX_HEIGHT)
+        height *= 2;
+      height = std::min(height, GLYPH_ATLAS_MAX_HEIGHT);
+      if (shelf_y + h > height) {
+        reset(image.height());
+      } else {
+        BLImage old = image;
+        image.create(GLYPH_ATLAS_WIDTH, height, BL_FORMAT_A8);
+        BLContext ctx(image);
+        ctx.clear_all();
+        ctx.blit_image(BLPointI(0, 0), old);
+        ctx.end();
+      }
+    }
+    at = BLPointI(shelf_x, shelf_y);
+    shelf_x += w;
+    shelf_h = std::max(shelf_h, h);
+    return true;
   }
 
-  double available_width = max_width - ellipsis_width;
+  const GlyphSlot &get(const BLFont &font, uint32_t glyph_id, int subpixel) {
+    uint64_t key = (uint64_t)glyph_id * GLYPH_SUBPIXEL_STEPS + subpixel;
+    auto it = glyphs.find(key);
+    if (it != glyphs.end())
+      return it->second;
 
-  size_t len = text.length();
+    GlyphSlot slot;
+    BLPath path;
+    BLBox box{};
+    font.get_glyph_outlines(glyph_id, BLMatrix2D::make_identity(), path);
+    if (path.is_empty() || path.get_bounding_box(&box) != BL_SUCCESS)
+      return glyphs.emplace(key, slot).first->second;
+
+    // one pixel of padding keeps antialiased edges off the neighbours
+    double dx = (double)subpixel / GLYPH_SUBPIXEL_STEPS;
+    slot.left = (int)std::floor(box.x0 + dx) - 1;
+    slot.top = (int)std::floor(box.y0) - 1;
+    int w = (int)std::ceil(box.x1 + dx) + 1 - slot.left;
+    int h = (int)std::ceil(box.y1) + 1 - slot.top;
+
+    BLPointI at;
+    if (!allocate(w, h, at)) {
+      slot.fits = false;
+      return glyphs.emplace(key, slot).first->second;
+    }
+    slot.area = BLRectI(at.x, at.y, w, h);
 
-  for (size_t i = 1; i < len; ++i) {
-    if ((text[i] & 0xC0) == 0x80)
-      continue;
+    BLContext ctx(image);
+    ctx.translate(at.x - slot.left + dx, at.y - slot.top);
+    ctx.fill_path(path, BLRgba32(0xFFFFFFFF));
+    ctx.end();
+    return glyphs.emplace(key, slot).first->second;
+  }
+};
 
-    std::string temp = text.substr(0, i);
-    gb.set_utf8_text(temp.c_str());
-    font.shape(gb);
-    font.get_text_metrics(gb, tm);
+struct GlyphCache {
+  std::mutex mutex;
+  std::unordered_map<std::string, GlyphAtlas> atlases;
+};
 
-    if (tm.advance.x > available_width) {
-      size_t prev = i - 1;
-      while (prev > 0 && (text[prev] & 0xC0) == 0x80)
-        prev--;
+GlyphCache &glyph_cache() {
+  static GlyphCache cache;
+  return cache;
+}
 
-      return text.substr(0, prev) + ellipsis;
+} // namespace
+
+void fill_text_run(BLContext &ctx, const BLPoint &origin, const BLFont &font,
+                   const TextRun &run, size_t first, size_t count) {
+  size_t glyph_count = run.advances.size();
+  first = std::min(first, glyph_count);
+  count = std::min(count, glyph_count - first);
+  if (count == 0)
+    return;
+
+  auto &cache = glyph_cache();
+  std::lock_guard<std::mutex> lock(cache.mutex);
+  std::string key = std::to_string(font.face().unique_id());
+  key += '/';
+  key += std::to_string(font.size());
+  auto &atlas = cache.atlases[key];
+  if (atlas.image.empty())
+    atlas.reset(64);
+
+  BLGlyphRun glyph_run = run.glyphs.glyph_run();
+  const auto *ids = static_cast<const uint8_t *>(glyph_run.glyph_data);
+  double start = first > 0 ? run.advances[first - 1] : 0;
+  int baseline = (int)std::lround(origin.y);
+
+  for (size_t i = first; i < first + count; ++i) {
+    double pen = i > 0 ? run.advances[i - 1] : 0;
+    double x = origin.x + (pen - start) + run.offsets[i].x;
+    int y = baseline + (int)std::lround(run.offsets[i].y);
+
+    int ix = (int)std::floor(x);
+    int subpixel = (int)std::lround((x - ix) * GLYPH_SUBPIXEL_STEPS);
+    if (subpixel == GLYPH_SUBPIXEL_STEPS) {
+      ++ix;
+      subpixel = 0;
     }
+
+    uint32_t glyph_id = *reinterpret_cast<const uint32_t *>(
+        ids + i * glyph_run.glyph_advance);
+    const GlyphSlot &slot = atlas.get(font, glyph_id, subpixel);
+    if (!slot.fits) {
+      // too large for the atlas, let blend2d draw it directly
+      ctx.fill_glyph_run(BLPoint(origin.x + (pen - start), origin.y), font,
+                         run.slice(i, 1));
+      continue;
+    }
+    if (slot.area.w == 0)
+      continue;
+    ctx.fill_mask(BLPointI(ix + slot.left, y + slot.top), atlas.image,
+                  slot.area);
+  }
+}
+
+namespace {
+
+// c * a / 255, rounded
+inline uint32_t premultiply(uint32_t c, uint32_t a) {
+  uint32_t x = c * a + 128;
+  return (x + (x >> 8)) >> 8;
+}
+
+void rgba_to_prgb32_scalar(uint8_t *p, size_t count) {
+  for (size_t i = 0; i < count; ++i, p += 4) {
+    uint32_t a = p[3];
+    uint32_t px = (a << 24) | (premultiply(p[0], a) << 16) |
+                  (premultiply(p[1], a) << 8) | premultiply(p[2], a);
+    std::memcpy(p, &px, sizeof(px));
   }
+}
+
+#ifdef LAWNCH_GFX_X86
+
+// 16 bit channels of two pixels times their alpha, divided by 255
+__attribute__((target("ssse3"))) inline __m128i
+premultiply_ssse3(__m128i c) {
+  __m128i a = _mm_shufflehi_epi16(_mm_shufflelo_epi16(c, 0xFF), 0xFF);
+  __m128i x = _mm_add_epi16(_mm_mullo_epi16(c, a), _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(x, _mm_srli_epi16(x, 8)), 8);
+}
+
+// Four pixels at a time: swap R and B, widen to 16 bits, multiply by the
+// alpha of each pixel and pack back, keeping the original alpha bytes.
+__attribute__((target("ssse3"))) void rgba_to_prgb32_ssse3(uint8_t *p,
+                                                            size_t count) {
+  const __m128i swizzle =
+      _mm_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  const __m128i alpha_mask = _mm_set1_epi32((int)0xFF000000);
+  const __m128i zero = _mm_setzero_si128();
+
+  size_t i = 0;
+  for (; i + 4 <= count; i += 4) {
+    auto *at = reinterpret_cast<__m128i *>(p + i * 4);
+    __m128i px = _mm_shuffle_epi8(_mm_loadu_si128(at), swizzle);
+    __m128i lo = premultiply_ssse3(_mm_unpacklo_epi8(px, zero));
+    __m128i hi = premultiply_ssse3(_mm_unpackhi_epi8(px, zero));
+    __m128i out = _mm_packus_epi16(lo, hi);
+    out = _mm_or_si128(_mm_andnot_si128(alpha_mask, out),
+                       _mm_and_si128(alpha_mask, px));
+    _mm_storeu_si128(at, out);
+  }
+  rgba_to_prgb32_scalar(p + i * 4, count - i);
+}
+
+__attribute__((target("avx2"))) inline __m256i premultiply_avx2(__m256i c) {
+  __m256i a = _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(c, 0xFF), 0xFF);
+  __m256i x =
+      _mm256_add_epi16(_mm256_mullo_epi16(c, a), _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(x, _mm256_srli_epi16(x, 8)), 8);
+}
+
+// Same as the SSSE3 version with eight pixels per step, every instruction
+// works within its 128 bit lane so the layout matches.
+__attribute__((target("avx2"))) void rgba_to_prgb32_avx2(uint8_t *p,
+                                                          size_t count) {
+  const __m256i swizzle = _mm256_setr_epi8(
+      2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15, 2, 1, 0, 3, 6, 5,
+      4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  const __m256i alpha_mask = _mm256_set1_epi32((int)0xFF000000);
+  const __m256i zero = _mm256_setzero_si256();
+
+  size_t i = 0;
+  for (; i + 8 <= count; i += 8) {
+    auto *at = reinterpret_cast<__m256i *>(p + i * 4);
+    __m256i px = _mm256_shuffle_epi8(_mm256_loadu_si256(at), swizzle);
+    __m256i lo = premultiply_avx2(_mm256_unpacklo_epi8(px, zero));
+    __m256i hi = premultiply_avx2(_mm256_unpackhi_epi8(px, zero));
+    __m256i out = _mm256_packus_epi16(lo, hi);
+    out = _mm256_or_si256(_mm256_andnot_si256(alpha_mask, out),
+                          _mm256_and_si256(alpha_mask, px));
+    _mm256_storeu_si256(at, out);
+  }
+  rgba_to_prgb32_ssse3(p + i * 4, count - i);
+}
+
+#endif
+
+} // namespace
+
+void rgba_to_prgb32(void *pixels, size_t count) {
+  auto *p = static_cast<uint8_t *>(pixels);
+#ifdef LAWNCH_GFX_X86
+  // picked once, the build itself targets the baseline
+  static const int level = [] {
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+      return 2;
+    if (__builtin_cpu_supports("ssse3"))
+      return 1;
+    return 0;
+  }();
+  if (level == 2)
+    return rgba_to_prgb32_avx2(p, count);
+  if (level == 1)
+    return rgba_to_prgb32_ssse3(p, count);
+#endif
+  rgba_to_prgb32_scalar(p, count);
+}
+
+std::string truncate_text(const std::string &text, const BLFont &font,
+                          double max_width) {
+  if (text.empty())
+    return "";
+
+  auto run = shape_text(font, text);
+  if (run->width <= max_width)
+    return text;
+
+  const std::string ellipsis = "...";
+  auto ellipsis_run = shape_text(font, ellipsis);
+  if (ellipsis_run->width >= max_width)
+    return ellipsis;
 
-  return text + ellipsis;
+  size_t end = run->fit(max_width - ellipsis_run->width);
+  if (end >= text.size())
+    return text + ellipsis;
+  return text.substr(0, end) + ellipsis;
 }
 
 } // namespace Lawnch::Gfx
@@ -1,7 +1,10 @@
 #pragma once
 #include "config_parse.hpp"
 #include <blend2d.h>
+#include <cstdint>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace Lawnch::Gfx {
 BLRgba32 toBLColor(const Config::Color &c);
@@ -12,7 +15,41 @@ BLRoundRect rounded_rect(double x, double y, double width, double height,
 BLFont get_font(const std::string &family, double size,
                 const std::string &weight = "normal");
 
-std::string truncate_text(const std::string &text, BLFont &font,
+// A string shaped once with one font. advances[i] is the pen position after
+// glyph i, offsets[i] where glyph i sits relative to its pen position and
+// clusters[i] the byte offset glyph i starts at.
+struct TextRun {
+  BLGlyphBuffer glyphs;
+  std::vector<double> advances;
+  std::vector<BLPoint> offsets;
+  std::vector<uint32_t> clusters;
+  double width = 0;
+
+  // byte length of the longest prefix no wider than max_width
+  size_t fit(double max_width) const;
+  // pen position at a byte offset into the text
+  double advance_at(size_t byte_offset) const;
+  // `count` glyphs starting at `first`, drawable on their own
+  BLGlyphRun slice(size_t first, size_t count) const;
+};
+
+// Shapes through a bounded cache keyed by font and text, so strings drawn on
+// every frame are only shaped once.
+std::shared_ptr<const TextRun> shape_text(const BLFont &font,
+                                          const std::string &text);
+
+// Draws `count` glyphs of `run` starting at `first` with the context's fill
+// style. Glyphs are rasterized once per font into an A8 atlas and composited
+// from there, `font` has to be the one the run was shaped with.
+void fill_text_run(BLContext &ctx, const BLPoint &origin, const BLFont &font,
+                   const TextRun &run, size_t first = 0,
+                   size_t count = SIZE_MAX);
+
+// Converts `count` straight alpha RGBA pixels, as nanosvg writes them, to
+// blend2d's premultiplied BGRA (BL_FORMAT_PRGB32) in place.
+void rgba_to_prgb32(void *pixels, size_t count);
+
+std::string truncate_text(const std::string &text, const BLFont &font,
                           double max_width);
 
 } // namespace Lawnch::Gfx
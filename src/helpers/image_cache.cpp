@@ -1,12 +1,28 @@
 #include "image_cache.hpp"
 #include "fs.hpp"
+#include "logger.hpp"
 #include "string.hpp"
+#include "thumbnails.hpp"
 #include <algorithm>
-#include <chrono>
+#include <cinttypes>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
 #include <iostream>
+#include <sstream>
+#include <sys/stat.h>
 
 namespace Lawnch::ImageCache {
 
+namespace {
+
+// bumped whenever the index or the key format changes
+constexpr int INDEX_VERSION = 1;
+// how long an image on screen goes before a worker checks its file again
+constexpr auto REVALIDATE_INTERVAL = std::chrono::seconds(2);
+
+} // namespace
+
 ImageCache &ImageCache::Instance() {
   static ImageCache inst;
   return inst;
@@ -18,7 +34,12 @@ ImageCache::ImageCache() {
     std::filesystem::create_directories(cache_dir);
   }
 
-  worker = std::thread(&ImageCache::worker_loop, this);
+  // decoding is cpu bound, one core is left for the compositor and us
+  unsigned count =
+      std::clamp(std::thread::hardware_concurrency(), 2u, 9u) - 1;
+  for (unsigned i = 0; i < count; ++i) {
+    workers.emplace_back(&ImageCache::worker_loop, this);
+  }
 }
 
 ImageCache::~ImageCache() {
@@ -28,9 +49,11 @@ ImageCache::~ImageCache() {
   }
   queue_cv.notify_all();
 
-  if (worker.joinable()) {
-    worker.join();
+  for (auto &worker : workers) {
+    if (worker.joinable())
+      worker.join();
   }
+  save_index();
 }
 
 void ImageCache::set_render_callback(std::function<void()> cb) {
@@ -39,36 +62,171 @@ void ImageCache::set_render_callback(std::function<void()> cb) {
 }
 
 std::string ImageCache::get_cache_key(const std::string &path, int w, int h) {
-  return std::to_string(Lawnch::Str::hash(path)) + "_" + std::to_string(w) +
-         "x" + std::to_string(h) + ".png";
+  return path + '\n' + std::to_string(w) + "x" + std::to_string(h);
+}
+
+std::string ImageCache::get_disk_key(const std::string &path, int w, int h) {
+  // an edited or replaced file gets a new key, a moved one keeps it
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+    return {};
+
+  std::string identity =
+      std::to_string(st.st_dev) + ":" + std::to_string(st.st_ino) + ":" +
+      std::to_string(st.st_size) + ":" + std::to_string(st.st_mtim.tv_sec) +
+      "." + std::to_string(st.st_mtim.tv_nsec);
+
+  char hash[17];
+  std::snprintf(hash, sizeof(hash), "%016" PRIx64,
+                Lawnch::Str::stable_hash(identity));
+  return std::string(hash) + "_" + std::to_string(w) + "x" +
+         std::to_string(h) + ".png";
 }
 
-std::filesystem::path ImageCache::get_disk_cache_path(const std::string &key) {
-  return cache_dir / key;
+std::filesystem::path
+ImageCache::get_disk_cache_path(const std::string &disk_key) {
+  return cache_dir / disk_key;
 }
 
-std::filesystem::path ImageCache::get_image(const std::string &path, int w,
-                                            int h) {
+void ImageCache::set_memory_budget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(queue_mutex);
+  memory_budget = bytes;
+  evict();
+}
+
+void ImageCache::set_disk_cache(bool enabled) {
+  std::lock_guard<std::mutex> lock(queue_mutex);
+  disk_cache = enabled;
+}
+
+void ImageCache::set_disk_budget(size_t bytes) {
+  std::lock_guard<std::mutex> lock(index_mutex);
+  disk_budget = bytes;
+}
+
+void ImageCache::set_shared_thumbnails(bool read, bool write) {
+  std::lock_guard<std::mutex> lock(queue_mutex);
+  read_shared_thumbnails = read;
+  write_shared_thumbnails = write;
+}
+
+std::optional<BLImage> ImageCache::get_image(const std::string &path, int w,
+                                             int h) {
   if (path.empty())
-    return {};
+    return std::nullopt;
 
   std::string key = get_cache_key(path, w, h);
-  std::filesystem::path disk_path = get_disk_cache_path(key);
+  std::optional<BLImage> image;
+  bool stale = false;
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    requested.insert(key);
+    auto it = images.find(key);
+    if (it != images.end()) {
+      lru.splice(lru.begin(), lru, it->second.order);
+      // the file may have been edited since, a worker takes a look
+      auto now = std::chrono::steady_clock::now();
+      if (now - it->second.checked >= REVALIDATE_INTERVAL) {
+        it->second.checked = now;
+        stale = true;
+      }
+      image = it->second.image;
+    }
+  }
+
+  if (!image || stale)
+    enqueue(key, path, w, h, 0, stale);
+  return image;
+}
 
-  if (std::filesystem::exists(disk_path)) {
-    return disk_path;
+void ImageCache::prefetch(const std::string &path, int w, int h,
+                          int distance) {
+  if (path.empty())
+    return;
+  enqueue(get_cache_key(path, w, h), path, w, h, std::max(distance, 1));
+}
+
+void ImageCache::begin_requests() {
+  std::lock_guard<std::mutex> lock(queue_mutex);
+  job_queue.clear();
+  queued.clear();
+  requested.clear();
+}
+
+void ImageCache::enqueue(const std::string &key, const std::string &path,
+                         int w, int h, int distance, bool revalidate) {
+  std::lock_guard<std::mutex> lock(queue_mutex);
+  if ((!revalidate && images.count(key)) || failed_keys.count(key) ||
+      in_flight.count(key))
+    return;
+
+  auto it = queued.find(key);
+  if (it != queued.end()) {
+    // already closer to the selection than this request
+    if (it->second.first <= distance)
+      return;
+    auto node = job_queue.extract(it->second);
+    node.key() = {distance, next_request++};
+    it->second = node.key();
+    job_queue.insert(std::move(node));
+    return;
   }
 
-  {
-    std::lock_guard<std::mutex> lock(queue_mutex);
-    if (pending_keys.find(key) == pending_keys.end()) {
-      pending_keys.insert(key);
-      job_queue.push_back({path, w, h});
-      queue_cv.notify_one();
+  JobOrder order{distance, next_request++};
+  job_queue.emplace(order, Job{key, path, w, h});
+  queued.emplace(key, order);
+  queue_cv.notify_one();
+}
+
+bool ImageCache::store(const std::string &key, BLImage image,
+                       const std::string &disk_key) {
+  remove(key);
+
+  size_t bytes = (size_t)image.width() * image.height() * 4;
+  if (!requested.count(key)) {
+    size_t on_screen = 0;
+    for (const auto &k : requested) {
+      auto it = images.find(k);
+      if (it != images.end())
+        on_screen += it->second.bytes;
     }
+    if (on_screen + bytes > memory_budget)
+      return false;
   }
 
-  return {};
+  lru.push_front(key);
+  images.emplace(key, Entry{std::move(image), bytes, lru.begin(), disk_key,
+                            std::chrono::steady_clock::now()});
+  memory_used += bytes;
+  evict();
+  return true;
+}
+
+void ImageCache::remove(const std::string &key) {
+  auto it = images.find(key);
+  if (it == images.end())
+    return;
+  memory_used -= it->second.bytes;
+  lru.erase(it->second.order);
+  images.erase(it);
+}
+
+void ImageCache::evict() {
+  // what is on screen goes last, and the newest image stays even when it is
+  // over budget on its own
+  for (bool on_screen : {false, true}) {
+    auto it = lru.end();
+    while (memory_used > memory_budget && lru.size() > 1 &&
+           it != lru.begin()) {
+      --it;
+      if (it == lru.begin() || (bool)requested.count(*it) != on_screen)
+        continue;
+      auto entry = images.find(*it);
+      memory_used -= entry->second.bytes;
+      images.erase(entry);
+      it = lru.erase(it);
+    }
+  }
 }
 
 void ImageCache::worker_loop() {
@@ -82,35 +240,249 @@ void ImageCache::worker_loop() {
       if (!running)
         return;
 
-      current_job = job_queue.front();
-      job_queue.pop_front();
+      auto it = job_queue.begin();
+      current_job = std::move(it->second);
+      job_queue.erase(it);
+      queued.erase(current_job.key);
+      in_flight.insert(current_job.key);
     }
 
-    process_image(current_job.path, current_job.w, current_job.h);
+    process_image(current_job);
 
+    bool idle;
+    bool use_disk;
     {
       std::lock_guard<std::mutex> lock(queue_mutex);
-      std::string key =
-          get_cache_key(current_job.path, current_job.w, current_job.h);
-      pending_keys.erase(key);
-      if (render_callback)
-        render_callback();
+      idle = job_queue.empty() && in_flight.empty();
+      use_disk = disk_cache;
     }
+    // after the job, the first preview does not wait for the directory scan
+    if (use_disk)
+      std::call_once(index_loaded, &ImageCache::load_index, this);
+    if (idle)
+      save_index();
+  }
+}
 
-    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+void ImageCache::process_image(const Job &job) {
+  const std::string &key = job.key;
+  std::string disk_key = get_disk_key(job.path, job.w, job.h);
+
+  bool use_disk;
+  bool read_shared;
+  bool write_shared;
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    auto it = images.find(key);
+    if (it != images.end() && !disk_key.empty() &&
+        it->second.disk_key == disk_key) {
+      // revalidated, the file did not change
+      in_flight.erase(key);
+      return;
+    }
+    use_disk = disk_cache;
+    read_shared = read_shared_thumbnails;
+    write_shared = write_shared_thumbnails;
+  }
+
+  BLImage result;
+  BLImage thumbnail;
+  std::filesystem::path disk_path;
+  bool from_disk = false;
+  if (!disk_key.empty()) {
+    disk_path = get_disk_cache_path(disk_key);
+    from_disk = use_disk && std::filesystem::exists(disk_path) &&
+                result.read_from_file(disk_path.string().c_str()) ==
+                    BL_SUCCESS;
+    if (from_disk) {
+      std::error_code ec;
+      uint64_t bytes = std::filesystem::file_size(disk_path, ec);
+      std::lock_guard<std::mutex> lock(index_mutex);
+      touch_disk_entry(disk_key, ec ? 0 : bytes);
+    } else {
+      result = decode(job, read_shared, write_shared, thumbnail);
+    }
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(queue_mutex);
+    in_flight.erase(key);
+    bool changed = true;
+    if (result.empty()) {
+      // gone or broken now, whatever was in memory is out of date
+      remove(key);
+      failed_keys.insert(key);
+    } else {
+      changed = store(key, result, disk_key);
+    }
+    // a dropped prefetch changes nothing on screen, and rendering again
+    // would only prefetch it again
+    if (changed && render_callback)
+      render_callback();
+  }
+
+  if (!thumbnail.empty()) {
+    int bucket = Lawnch::Thumbnails::bucket_size(std::max(job.w, job.h));
+    Lawnch::Thumbnails::store(job.path, bucket, thumbnail);
+  }
+
+  // the preview already has the image, the copy on disk is for next time
+  if (use_disk && !from_disk && !result.empty() &&
+      result.write_to_file(disk_path.string().c_str()) == BL_SUCCESS) {
+    std::error_code ec;
+    uint64_t bytes = std::filesystem::file_size(disk_path, ec);
+    {
+      std::lock_guard<std::mutex> lock(index_mutex);
+      touch_disk_entry(disk_key, ec ? 0 : bytes);
+    }
+    sweep_disk();
   }
 }
 
-void ImageCache::process_image(const std::string &path, int w, int h) {
-  std::string key = get_cache_key(path, w, h);
-  std::filesystem::path disk_path = get_disk_cache_path(key);
+void ImageCache::load_index() {
+  std::unordered_map<std::string, int64_t> last_access;
+  std::ifstream file(cache_dir / "index");
+  std::string line;
+  if (std::getline(file, line) &&
+      line == "VERSION:" + std::to_string(INDEX_VERSION)) {
+    while (std::getline(file, line)) {
+      if (line.rfind("ENTRY:", 0) != 0)
+        continue;
+      size_t sep = line.find(':', 6);
+      if (sep == std::string::npos)
+        continue;
+      try {
+        last_access[line.substr(sep + 1)] =
+            std::stoll(line.substr(6, sep - 6));
+      } catch (...) {
+      }
+    }
+  }
 
-  if (std::filesystem::exists(disk_path))
+  // the directory is the truth, the index only adds access times. Files
+  // it does not know, like ones from older versions, count as last used
+  // when they were written.
+  std::unordered_map<std::string, DiskEntry> entries;
+  uint64_t used = 0;
+  std::error_code ec;
+  for (const auto &dir_entry :
+       std::filesystem::directory_iterator(cache_dir, ec)) {
+    if (dir_entry.path().extension() != ".png")
+      continue;
+    struct stat st;
+    if (stat(dir_entry.path().c_str(), &st) != 0 || !S_ISREG(st.st_mode))
+      continue;
+
+    std::string name = dir_entry.path().filename().string();
+    auto it = last_access.find(name);
+    int64_t accessed = it != last_access.end() ? it->second : st.st_mtime;
+    entries[name] = {accessed, (uint64_t)st.st_size};
+    used += st.st_size;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(index_mutex);
+    // images read or written before the scan finished are newer
+    for (const auto &[name, entry] : disk_index) {
+      entries[name] = entry;
+    }
+    used = 0;
+    for (const auto &[name, entry] : entries) {
+      used += entry.bytes;
+    }
+    disk_index = std::move(entries);
+    disk_used = used;
+    index_dirty = true;
+  }
+  sweep_disk();
+}
+
+void ImageCache::save_index() {
+  std::lock_guard<std::mutex> lock(index_mutex);
+  if (!index_dirty)
     return;
+  index_dirty = false;
+
+  std::ostringstream file;
+  file << "VERSION:" << INDEX_VERSION << "\n";
+  for (const auto &[name, entry] : disk_index) {
+    file << "ENTRY:" << entry.last_access << ":" << name << "\n";
+  }
+
+  if (!Lawnch::Fs::write_file_atomic(cache_dir / "index", file.str())) {
+    Lawnch::Logger::log("ImageCache", Lawnch::Logger::LogLevel::ERROR,
+                        "Failed to write preview cache index.");
+  }
+}
+
+void ImageCache::touch_disk_entry(const std::string &key, uint64_t bytes) {
+  auto &entry = disk_index[key];
+  disk_used = disk_used - entry.bytes + bytes;
+  entry.bytes = bytes;
+  entry.last_access = std::time(nullptr);
+  index_dirty = true;
+}
+
+void ImageCache::sweep_disk() {
+  std::vector<std::string> victims;
+  {
+    std::lock_guard<std::mutex> lock(index_mutex);
+    if (disk_used <= disk_budget)
+      return;
+
+    std::vector<std::pair<int64_t, std::string>> by_age;
+    by_age.reserve(disk_index.size());
+    for (const auto &[name, entry] : disk_index) {
+      by_age.emplace_back(entry.last_access, name);
+    }
+    std::sort(by_age.begin(), by_age.end());
+
+    // a bit below the budget, so the next few writes don't sweep again
+    uint64_t target = disk_budget - disk_budget / 8;
+    for (const auto &[accessed, name] : by_age) {
+      if (disk_used <= target)
+        break;
+      auto it = disk_index.find(name);
+      disk_used -= it->second.bytes;
+      disk_index.erase(it);
+      victims.push_back(name);
+    }
+    index_dirty = true;
+  }
+
+  // a worker still reading one of these just decodes the original again
+  std::error_code ec;
+  for (const auto &name : victims) {
+    std::filesystem::remove(cache_dir / name, ec);
+  }
+}
+
+BLImage ImageCache::decode(const Job &job, bool read_shared,
+                           bool write_shared, BLImage &thumbnail) {
+  int size = std::max(job.w, job.h);
+  if (read_shared) {
+    if (auto shared = Lawnch::Thumbnails::find(job.path, size))
+      return scale_image(std::move(*shared), job.w, job.h);
+  }
 
   BLImage original;
-  if (original.read_from_file(path.c_str()) != BL_SUCCESS) {
-    return;
+  if (original.read_from_file(job.path.c_str()) != BL_SUCCESS) {
+    return {};
+  }
+
+  // the spec leaves images smaller than the thumbnail alone
+  int bucket = write_shared ? Lawnch::Thumbnails::bucket_size(size) : 0;
+  if (bucket > 0 &&
+      (original.width() > bucket || original.height() > bucket)) {
+    thumbnail = scale_image(std::move(original), bucket, bucket);
+    return scale_image(thumbnail, job.w, job.h);
+  }
+  return scale_image(std::move(original), job.w, job.h);
+}
+
+BLImage ImageCache::scale_image(BLImage original, int w, int h) {
+  if (original.empty()) {
+    return {};
   }
 
   int img_w = original.width();
@@ -122,8 +494,7 @@ void ImageCache::process_image(const std::string &path, int w, int h) {
   int target_h = static_cast<int>(img_h * scale);
 
   if (target_w <= 0 || target_h <= 0) {
-    original.reset();
-    return;
+    return {};
   }
 
   BLImage current = std::move(original);
@@ -153,10 +524,8 @@ void ImageCache::process_image(const std::string &path, int w, int h) {
   final_ctx.blit_image(BLRect(0, 0, target_w, target_h), current,
                        BLRectI(0, 0, cur_w, cur_h));
   final_ctx.end();
-  current.reset();
 
-  result.write_to_file(disk_path.string().c_str());
-  result.reset();
+  return result;
 }
 
 } // namespace Lawnch::ImageCache
@@ -2,22 +2,47 @@
 
 #include <atomic>
 #include <blend2d.h>
+#include <chrono>
 #include <condition_variable>
-#include <deque>
+#include <cstddef>
+#include <cstdint>
 #include <filesystem>
 #include <functional>
+#include <list>
+#include <map>
 #include <mutex>
+#include <optional>
 #include <string>
 #include <thread>
+#include <unordered_map>
 #include <unordered_set>
+#include <vector>
 
 namespace Lawnch::ImageCache {
 
 class ImageCache {
 public:
   static ImageCache &Instance();
-  std::filesystem::path get_image(const std::string &path, int w, int h);
+
+  // Queued images that are not asked for again after this are dropped, so
+  // the queue only ever holds what is on screen or close to it.
+  void begin_requests();
+  // The image scaled to fit w x h if it is in memory. Otherwise it is queued
+  // ahead of everything else and the render callback fires once it is.
+  std::optional<BLImage> get_image(const std::string &path, int w, int h);
+  // Loads the image in the background. Lower distances from the selection
+  // are loaded first.
+  void prefetch(const std::string &path, int w, int h, int distance);
+
   void set_render_callback(std::function<void()> cb);
+  void set_memory_budget(size_t bytes);
+  // whether scaled images are also written to disk for the next run
+  void set_disk_cache(bool enabled);
+  // least recently used files are swept once the disk copies add up to more
+  void set_disk_budget(size_t bytes);
+  // whether thumbnails other applications made are used instead of decoding
+  // the original, and whether ours are shared with them
+  void set_shared_thumbnails(bool read, bool write);
 
 private:
   ImageCache();
@@ -25,28 +50,94 @@ private:
   ImageCache(const ImageCache &) = delete;
   ImageCache &operator=(const ImageCache &) = delete;
 
+  struct Job {
+    std::string key;
+    std::string path;
+    int w;
+    int h;
+  };
+
   void worker_loop();
-  void process_image(const std::string &path, int w, int h);
+  void process_image(const Job &job);
+  // The image scaled to fit the job. `thumbnail` is set when the original
+  // had to be decoded and should be shared.
+  BLImage decode(const Job &job, bool read_shared, bool write_shared,
+                 BLImage &thumbnail);
+  BLImage scale_image(BLImage original, int w, int h);
+  // `revalidate` queues an image that is in memory to see whether its
+  // file changed
+  void enqueue(const std::string &key, const std::string &path, int w, int h,
+               int distance, bool revalidate = false);
+  // all expect queue_mutex to be held
+  // false if the image was prefetched and would only fit by pushing out
+  // what is on screen, it is dropped then
+  bool store(const std::string &key, BLImage image,
+             const std::string &disk_key);
+  void remove(const std::string &key);
+  void evict();
 
+  // the key in memory, touches nothing on disk so it is fine to render with
   std::string get_cache_key(const std::string &path, int w, int h);
-  std::filesystem::path get_disk_cache_path(const std::string &key);
+  // name of the copy on disk, changes with the file. Stats the source, so
+  // workers only; empty if that fails.
+  std::string get_disk_key(const std::string &path, int w, int h);
+  std::filesystem::path get_disk_cache_path(const std::string &disk_key);
+
+  void load_index();
+  void save_index();
+  // expects index_mutex to be held
+  void touch_disk_entry(const std::string &key, uint64_t bytes);
+  void sweep_disk();
 
   std::filesystem::path cache_dir;
   std::function<void()> render_callback;
 
-  std::thread worker;
+  // ordered by (distance from the selection, then request order)
+  using JobOrder = std::pair<int, uint64_t>;
+
+  std::vector<std::thread> workers;
   std::atomic<bool> running{true};
   std::mutex queue_mutex;
   std::condition_variable queue_cv;
 
-  struct Job {
-    std::string path;
-    int w;
-    int h;
+  uint64_t next_request = 0;
+  std::map<JobOrder, Job> job_queue;
+  std::unordered_map<std::string, JobOrder> queued;
+  // being decoded, there is no stopping those
+  std::unordered_set<std::string> in_flight;
+  // could not be decoded, not queued again
+  std::unordered_set<std::string> failed_keys;
+  // asked for with get_image() since begin_requests(), i.e. on screen
+  std::unordered_set<std::string> requested;
+
+  struct Entry {
+    BLImage image;
+    size_t bytes;
+    std::list<std::string>::iterator order;
+    std::string disk_key; // what the file looked like when it was loaded
+    std::chrono::steady_clock::time_point checked;
+  };
+
+  std::list<std::string> lru; // most recently used first
+  std::unordered_map<std::string, Entry> images;
+  size_t memory_used = 0;
+  size_t memory_budget = 64 * 1024 * 1024;
+  bool disk_cache = true;
+  bool read_shared_thumbnails = true;
+  bool write_shared_thumbnails = false;
+
+  struct DiskEntry {
+    int64_t last_access; // seconds since the epoch
+    uint64_t bytes;
   };
 
-  std::deque<Job> job_queue;
-  std::unordered_set<std::string> pending_keys;
+  // files in cache_dir, read after the first job and written back when idle
+  std::once_flag index_loaded;
+  std::mutex index_mutex;
+  std::unordered_map<std::string, DiskEntry> disk_index;
+  uint64_t disk_used = 0;
+  uint64_t disk_budget = 256 * 1024 * 1024;
+  bool index_dirty = false;
 };
 
 } // namespace Lawnch::ImageCache
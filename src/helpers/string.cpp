@@ -156,11 +156,19 @@ int match_score(std::string_view input, std::string_view target) {
   to_lower(in_lower);
   to_lower(tg_lower);
 
-  if (tg_lower == in_lower)
+  return match_score_lowered(in_lower, tg_lower);
+}
+
+int match_score_lowered(std::string_view input, std::string_view target) {
+  if (input.empty())
+    return 1;
+
+  if (target == input)
     return 100;
-  if (tg_lower.find(in_lower) == 0)
+  size_t pos = target.find(input);
+  if (pos == 0)
     return 80;
-  if (tg_lower.find(in_lower) != std::string::npos)
+  if (pos != std::string_view::npos)
     return 50;
 
   return 0;
@@ -176,4 +184,13 @@ size_t hash(std::string_view str) {
   return hasher(str);
 }
 
+uint64_t stable_hash(std::string_view str) {
+  uint64_t h = 0xcbf29ce484222325ULL;
+  for (unsigned char c : str) {
+    h ^= c;
+    h *= 0x100000001b3ULL;
+  }
+  return h;
+}
+
 } // namespace Lawnch::Str
@@ -1,4 +1,5 @@
 #pragma once
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
@@ -18,7 +19,12 @@ bool iequals(const std::string &a, const std::string &b);
 bool contains_ic(std::string_view haystack, std::string_view needle);
 bool is_url(const std::string &str);
 int match_score(std::string_view input, std::string_view target);
+// same as match_score but both sides must already be lowercase
+int match_score_lowered(std::string_view input, std::string_view target);
 size_t hash(std::string_view str);
+// FNV-1a, unlike hash() the same across builds and runs, for anything that
+// ends up on disk
+uint64_t stable_hash(std::string_view str);
 
 void to_lower(std::string &str);
 
@@ -0,0 +1,325 @@
+#include "thumbnails.hpp"
+#include "fs.hpp"
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string_view>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+namespace Lawnch::Thumbnails {
+
+namespace {
+
+struct Bucket {
+  const char *dir;
+  int size;
+};
+
+// smallest first
+constexpr Bucket BUCKETS[] = {
+    {"normal", 128}, {"large", 256}, {"x-large", 512}, {"xx-large", 1024}};
+
+constexpr uint8_t PNG_SIGNATURE[8] = {0x89, 'P', 'N', 'G',
+                                      '\r', '\n', 0x1a, '\n'};
+// signature plus the IHDR chunk, which always comes first
+constexpr size_t IHDR_END = 8 + 12 + 13;
+// thumbnails are small, anything bigger is not one
+constexpr std::streamsize MAX_THUMBNAIL_BYTES = 16 * 1024 * 1024;
+
+constexpr uint32_t MD5_K[64] = {
+    0xd76aa478, 0xe8c7b756, 0x242070db, 0xc1bdceee, 0xf57c0faf, 0x4787c62a,
+    0xa8304613, 0xfd469501, 0x698098d8, 0x8b44f7af, 0xffff5bb1, 0x895cd7be,
+    0x6b901122, 0xfd987193, 0xa679438e, 0x49b40821, 0xf61e2562, 0xc040b340,
+    0x265e5a51, 0xe9b6c7aa, 0xd62f105d, 0x02441453, 0xd8a1e681, 0xe7d3fbc8,
+    0x21e1cde6, 0xc33707d6, 0xf4d50d87, 0x455a14ed, 0xa9e3e905, 0xfcefa3f8,
+    0x676f02d9, 0x8d2a4c8a, 0xfffa3942, 0x8771f681, 0x6d9d6122, 0xfde5380c,
+    0xa4beea44, 0x4bdecfa9, 0xf6bb4b60, 0xbebfbc70, 0x289b7ec6, 0xeaa127fa,
+    0xd4ef3085, 0x04881d05, 0xd9d4d039, 0xe6db99e5, 0x1fa27cf8, 0xc4ac5665,
+    0xf4292244, 0x432aff97, 0xab9423a7, 0xfc93a039, 0x655b59c3, 0x8f0ccc92,
+    0xffeff47d, 0x85845dd1, 0x6fa87e4f, 0xfe2ce6e0, 0xa3014314, 0x4e0811a1,
+    0xf7537e82, 0xbd3af235, 0x2ad7d2bb, 0xeb86d391};
+
+constexpr int MD5_SHIFT[16] = {7, 12, 17, 22, 5, 9,  14, 20,
+                               4, 11, 16, 23, 6, 10, 15, 21};
+
+// RFC 1321, only ever fed short URIs
+std::string md5_hex(std::string_view input) {
+  std::string msg(input);
+  uint64_t bit_length = (uint64_t)input.size() * 8;
+  msg += '\x80';
+  while (msg.size() % 64 != 56)
+    msg += '\0';
+  for (int i = 0; i < 8; ++i)
+    msg += (char)(bit_length >> (8 * i));
+
+  uint32_t h[4] = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476};
+  for (size_t chunk = 0; chunk < msg.size(); chunk += 64) {
+    uint32_t m[16];
+    for (int i = 0; i < 16; ++i) {
+      const auto *p = (const uint8_t *)msg.data() + chunk + i * 4;
+      m[i] = p[0] | p[1] << 8 | p[2] << 16 | (uint32_t)p[3] << 24;
+    }
+
+    uint32_t a = h[0], b = h[1], c = h[2], d = h[3];
+    for (int i = 0; i < 64; ++i) {
+      uint32_t f;
+      int g;
+      if (i < 16) {
+        f = (b & c) | (~b & d);
+        g = i;
+      } else if (i < 32) {
+        f = (d & b) | (~d & c);
+        g = (5 * i + 1) % 16;
+      } else if (i < 48) {
+        f = b ^ c ^ d;
+        g = (3 * i + 5) % 16;
+      } else {
+        f = c ^ (b | ~d);
+        g = (7 * i) % 16;
+      }
+      f += a + MD5_K[i] + m[g];
+      a = d;
+      d = c;
+      c = b;
+      b += std::rotl(f, MD5_SHIFT[i / 16 * 4 + i % 4]);
+    }
+    h[0] += a;
+    h[1] += b;
+    h[2] += c;
+    h[3] += d;
+  }
+
+  static const char HEX[] = "0123456789abcdef";
+  std::string out;
+  for (uint32_t word : h) {
+    for (int i = 0; i < 4; ++i) {
+      uint8_t byte = word >> (8 * i);
+      out += HEX[byte >> 4];
+      out += HEX[byte & 0xf];
+    }
+  }
+  return out;
+}
+
+uint32_t crc32(const uint8_t *data, size_t size) {
+  static const auto table = [] {
+    std::array<uint32_t, 256> t{};
+    for (uint32_t n = 0; n < 256; ++n) {
+      uint32_t c = n;
+      for (int k = 0; k < 8; ++k)
+        c = (c & 1) ? 0xedb88320u ^ (c >> 1) : c >> 1;
+      t[n] = c;
+    }
+    return t;
+  }();
+
+  uint32_t crc = 0xffffffffu;
+  for (size_t i = 0; i < size; ++i)
+    crc = table[(crc ^ data[i]) & 0xff] ^ (crc >> 8);
+  return crc ^ 0xffffffffu;
+}
+
+uint32_t read_be32(const uint8_t *p) {
+  return (uint32_t)p[0] << 24 | p[1] << 16 | p[2] << 8 | p[3];
+}
+
+void append_be32(std::vector<uint8_t> &out, uint32_t value) {
+  for (int shift = 24; shift >= 0; shift -= 8)
+    out.push_back((uint8_t)(value >> shift));
+}
+
+fs::path get_thumbnail_root() {
+  return ::Lawnch::Fs::get_cache_home() / "thumbnails";
+}
+
+std::string absolute_path(const std::string &path) {
+  std::error_code ec;
+  fs::path abs = fs::absolute(path, ec);
+  return ec ? path : abs.lexically_normal().string();
+}
+
+// escaped the way glib does it, the hash has to match other applications
+std::string file_uri(const std::string &abs_path) {
+  static const char HEX[] = "0123456789ABCDEF";
+  std::string uri = "file://";
+  for (unsigned char c : abs_path) {
+    bool plain = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') ||
+                 (c >= '0' && c <= '9') ||
+                 (c && std::strchr("-._~!$&'()*+,;=:@/", c));
+    if (plain) {
+      uri += (char)c;
+    } else {
+      uri += '%';
+      uri += HEX[c >> 4];
+      uri += HEX[c & 0xf];
+    }
+  }
+  return uri;
+}
+
+bool read_file(const fs::path &file, std::vector<uint8_t> &out) {
+  std::ifstream in(file, std::ios::binary | std::ios::ate);
+  if (!in.is_open())
+    return false;
+  std::streamsize size = in.tellg();
+  if (size <= 0 || size > MAX_THUMBNAIL_BYTES)
+    return false;
+  out.resize(size);
+  in.seekg(0);
+  return (bool)in.read((char *)out.data(), size);
+}
+
+// text of the first tEXt chunk with `keyword`
+std::optional<std::string> find_text(const std::vector<uint8_t> &png,
+                                     std::string_view keyword) {
+  if (png.size() < 8 ||
+      std::memcmp(png.data(), PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0)
+    return std::nullopt;
+
+  size_t pos = 8;
+  while (png.size() - pos >= 12) {
+    uint32_t length = read_be32(&png[pos]);
+    if (length > png.size() - pos - 12)
+      break;
+    const char *type = (const char *)&png[pos + 4];
+    const char *data = (const char *)&png[pos + 8];
+    if (std::memcmp(type, "IEND", 4) == 0)
+      break;
+    if (std::memcmp(type, "tEXt", 4) == 0 && length > keyword.size() &&
+        std::string_view(data, keyword.size()) == keyword &&
+        data[keyword.size()] == '\0') {
+      return std::string(data + keyword.size() + 1,
+                         length - keyword.size() - 1);
+    }
+    pos += 12 + length;
+  }
+  return std::nullopt;
+}
+
+void append_text(std::vector<uint8_t> &png, std::string_view keyword,
+                 std::string_view text) {
+  std::vector<uint8_t> chunk = {'t', 'E', 'X', 't'};
+  chunk.insert(chunk.end(), keyword.begin(), keyword.end());
+  chunk.push_back(0);
+  chunk.insert(chunk.end(), text.begin(), text.end());
+
+  append_be32(png, chunk.size() - 4);
+  png.insert(png.end(), chunk.begin(), chunk.end());
+  append_be32(png, crc32(chunk.data(), chunk.size()));
+}
+
+} // namespace
+
+int bucket_size(int size) {
+  for (const auto &bucket : BUCKETS) {
+    if (bucket.size >= size)
+      return bucket.size;
+  }
+  return 0;
+}
+
+std::optional<BLImage> find(const std::string &path, int size) {
+  struct stat st;
+  if (stat(path.c_str(), &st) != 0)
+    return std::nullopt;
+
+  std::string uri = file_uri(absolute_path(path));
+  std::string name = md5_hex(uri) + ".png";
+  std::string mtime = std::to_string(st.st_mtime);
+  fs::path root = get_thumbnail_root();
+
+  for (const auto &bucket : BUCKETS) {
+    if (bucket.size < size)
+      continue;
+
+    std::vector<uint8_t> png;
+    if (!read_file(root / bucket.dir / name, png))
+      continue;
+    // stale once the file changed, the uri is only there to rule out
+    // hash collisions
+    if (find_text(png, "Thumb::MTime") != mtime)
+      continue;
+    auto thumb_uri = find_text(png, "Thumb::URI");
+    if (thumb_uri && *thumb_uri != uri)
+      continue;
+
+    BLImage image;
+    if (image.read_from_data(png.data(), png.size()) == BL_SUCCESS)
+      return image;
+  }
+  return std::nullopt;
+}
+
+void store(const std::string &path, int bucket, const BLImage &image) {
+  const char *dir_name = nullptr;
+  for (const auto &b : BUCKETS) {
+    if (b.size == bucket)
+      dir_name = b.dir;
+  }
+  struct stat st;
+  if (!dir_name || image.empty() || stat(path.c_str(), &st) != 0)
+    return;
+
+  fs::path root = get_thumbnail_root();
+  std::string abs_path = absolute_path(path);
+  // no thumbnails of thumbnails
+  if (abs_path.rfind(root.string() + "/", 0) == 0)
+    return;
+  std::string uri = file_uri(abs_path);
+
+  BLImageCodec codec;
+  BLArray<uint8_t> encoded;
+  if (codec.find_by_name("PNG") != BL_SUCCESS ||
+      image.write_to_data(encoded, codec) != BL_SUCCESS)
+    return;
+  const uint8_t *data = encoded.data();
+  size_t size = encoded.size();
+  if (size < IHDR_END ||
+      std::memcmp(data, PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0 ||
+      std::memcmp(data + 12, "IHDR", 4) != 0)
+    return;
+
+  // the keys the spec requires go right after the header
+  std::vector<uint8_t> png(data, data + IHDR_END);
+  append_text(png, "Thumb::URI", uri);
+  append_text(png, "Thumb::MTime", std::to_string(st.st_mtime));
+  append_text(png, "Thumb::Size", std::to_string(st.st_size));
+  append_text(png, "Software", "lawnch");
+  png.insert(png.end(), data + IHDR_END, data + size);
+
+  // the spec wants the whole tree private
+  fs::path dir = root / dir_name;
+  std::error_code ec;
+  fs::create_directories(dir, ec);
+  fs::permissions(root, fs::perms::owner_all, ec);
+  fs::permissions(dir, fs::perms::owner_all, ec);
+
+  // written elsewhere and renamed, readers never see half a file
+  std::string tmp_file = (dir / "lawnch-XXXXXX").string();
+  int fd = mkstemp(tmp_file.data());
+  if (fd < 0)
+    return;
+  size_t written = 0;
+  while (written < png.size()) {
+    ssize_t n = ::write(fd, png.data() + written, png.size() - written);
+    if (n <= 0)
+      break;
+    written += n;
+  }
+  bool ok = ::close(fd) == 0 && written == png.size();
+
+  if (ok)
+    fs::rename(tmp_file, dir / (md5_hex(uri) + ".png"), ec);
+  if (!ok || ec)
+    fs::remove(tmp_file, ec);
+}
+
+} // namespace Lawnch::Thumbnails
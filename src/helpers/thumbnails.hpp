@@ -0,0 +1,23 @@
+#pragma once
+
+#include <blend2d.h>
+#include <optional>
+#include <string>
+
+// Shared thumbnails from the freedesktop thumbnail spec, the ones file
+// managers leave in $XDG_CACHE_HOME/thumbnails.
+namespace Lawnch::Thumbnails {
+
+// Edge of the smallest thumbnail size covering size x size, 0 if even the
+// largest is too small.
+int bucket_size(int size);
+
+// The smallest thumbnail of `path` covering size x size whose Thumb::MTime
+// still matches the file.
+std::optional<BLImage> find(const std::string &path, int size);
+
+// Writes `image`, already scaled to fit `bucket`, as the thumbnail of
+// `path` for other applications to pick up.
+void store(const std::string &path, int bucket, const BLImage &image);
+
+} // namespace Lawnch::Thumbnails